@@ -0,0 +1,229 @@
+#include <climits>
+#include <new>
+#include <thread>
+#include <chrono>
+
+#include "agentlink.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    const char *eventNames[2] = {"Local\\" AGENT_SEGMENT_NAME "_observation", "Local\\" AGENT_SEGMENT_NAME "_action"};
+#endif
+
+    void cpuRelax()
+    {
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+        _mm_pause();
+#endif
+    }
+
+    // Counters wrap, so compare by distance
+    bool reached(std::uint32_t value, std::uint32_t target)
+    {
+        return static_cast<std::int32_t>(value - target) >= 0;
+    }
+
+    void sleepOn(std::atomic<std::uint32_t> &word, std::uint32_t seen, void *event)
+    {
+#ifdef _WIN32
+        // Auto-reset events keep a wake that arrived early, so nothing is lost between check and wait
+        (void)word;
+        (void)seen;
+        WaitForSingleObject(static_cast<HANDLE>(event), AGENT_WAIT_MS);
+#elif defined(__linux__)
+        // Shared (not private) futex, the word lives in memory mapped by both processes.
+        // Returns straight away if the word no longer holds what we saw.
+        (void)event;
+        timespec timeout{0, AGENT_WAIT_MS * 1000000L};
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+#else
+        (void)word;
+        (void)seen;
+        (void)event;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+
+    void wakeOn(std::atomic<std::uint32_t> &word, void *event)
+    {
+#ifdef _WIN32
+        (void)word;
+        SetEvent(static_cast<HANDLE>(event));
+#elif defined(__linux__)
+        (void)event;
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)word;
+        (void)event;
+#endif
+    }
+}
+
+AgentLink::~AgentLink()
+{
+    close();
+    closeEvents();
+}
+
+bool AgentLink::create()
+{
+    if (!memory.create(AGENT_SEGMENT_NAME, sizeof(AgentSegment)))
+        return false;
+
+    segment = new (memory.data()) AgentSegment();
+    segment->magic = AGENT_SEGMENT_MAGIC;
+    segment->version = AGENT_SEGMENT_VERSION;
+    segment->ringSize = AGENT_RING_SIZE;
+    segment->maxBody = AGENT_MAX_BODY;
+    next = 0;
+
+    openEvents(true);
+    return true;
+}
+
+AgentObservation &AgentLink::nextObservation()
+{
+    return segment->ring[next % AGENT_RING_SIZE];
+}
+
+void AgentLink::publish()
+{
+    segment->published.store(next + 1, std::memory_order_seq_cst);
+    wake(segment->published, segment->observationWaiters, 0);
+}
+
+bool AgentLink::waitForAction(AgentAction &action)
+{
+    if (!waitUntil(segment->acted, segment->actionWaiters, next + 1, 1))
+        return false;
+
+    action = segment->action;
+    next++;
+    return true;
+}
+
+bool AgentLink::attach()
+{
+    if (!memory.open(AGENT_SEGMENT_NAME, sizeof(AgentSegment), true))
+        return false;
+
+    segment = static_cast<AgentSegment *>(memory.data());
+    if (segment->magic != AGENT_SEGMENT_MAGIC || segment->version != AGENT_SEGMENT_VERSION)
+    {
+        segment = nullptr;
+        memory.close();
+        return false;
+    }
+
+    // Pick up wherever the game is waiting
+    next = segment->acted.load(std::memory_order_acquire);
+    openEvents(false);
+    return true;
+}
+
+const AgentObservation *AgentLink::waitForObservation()
+{
+    if (!waitUntil(segment->published, segment->observationWaiters, next + 1, 0))
+        return nullptr;
+
+    // The game only writes ring[next + 1] after our action, so the last
+    // AGENT_RING_SIZE - 1 observations stay valid while we think
+    return &segment->ring[next % AGENT_RING_SIZE];
+}
+
+void AgentLink::act(const AgentAction &action)
+{
+    segment->action = action;
+    segment->acted.store(next + 1, std::memory_order_seq_cst);
+    wake(segment->acted, segment->actionWaiters, 1);
+    next++;
+}
+
+void AgentLink::close()
+{
+    if (segment == nullptr)
+        return;
+
+    segment->closed.store(1, std::memory_order_seq_cst);
+    wakeOn(segment->published, events[0]);
+    wakeOn(segment->acted, events[1]);
+    segment = nullptr;
+    memory.close();
+}
+
+bool AgentLink::waitUntil(std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters, std::uint32_t target, int event)
+{
+    // The other side usually answers within microseconds, so spin first.
+    // Not on a single core though, there spinning only delays the answer.
+    static const int spinCount = std::thread::hardware_concurrency() > 1 ? AGENT_SPIN_COUNT : 0;
+    for (int i = 0; i < spinCount; ++i)
+    {
+        if (reached(word.load(std::memory_order_acquire), target))
+            return true;
+        cpuRelax();
+    }
+
+    // Announce ourselves before the final check, pairs with the waiter check in wake()
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool ok = true;
+    while (true)
+    {
+        std::uint32_t seen = word.load(std::memory_order_seq_cst);
+        if (reached(seen, target))
+            break;
+        if (segment->closed.load(std::memory_order_acquire) != 0)
+        {
+            ok = false;
+            break;
+        }
+        sleepOn(word, seen, events[event]);
+    }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return ok;
+}
+
+void AgentLink::wake(std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters, int event)
+{
+    // Skip the syscall while the other side is still spinning
+    if (waiters.load(std::memory_order_seq_cst) != 0)
+        wakeOn(word, events[event]);
+}
+
+void AgentLink::openEvents(bool create)
+{
+#ifdef _WIN32
+    for (int i = 0; i < 2; ++i)
+    {
+        events[i] = create ? CreateEventA(nullptr, FALSE, FALSE, eventNames[i])
+                           : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, eventNames[i]);
+    }
+#else
+    (void)create;
+#endif
+}
+
+void AgentLink::closeEvents()
+{
+#ifdef _WIN32
+    for (void *&event : events)
+    {
+        if (event != nullptr)
+            CloseHandle(static_cast<HANDLE>(event));
+        event = nullptr;
+    }
+#endif
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "sharedmemory.hpp"
+
+#define AGENT_SEGMENT_NAME "snake_agent"
+#define AGENT_SEGMENT_MAGIC 0x534E4147u // "SNAG"
+#define AGENT_SEGMENT_VERSION 2u // 2: walls
+#define AGENT_RING_SIZE 8     // Latest observations kept, so agents can stack frames without copying
+#define AGENT_MAX_BODY 8192   // Body positions per observation, longer snakes are truncated
+#define AGENT_MAX_MAP_TILES 32768 // Wall tiles the segment can describe
+#define AGENT_SPIN_COUNT 4096 // Polls before sleeping in the kernel
+#define AGENT_WAIT_MS 100     // Sleep slice, the closed flag is checked in between
+
+// Action directions use the moveDirection values, anything else keeps going
+#define AGENT_ACTION_KEEP 4u
+
+struct AgentPoint
+{
+    float x;
+    float y;
+};
+
+// State after a tick, read in place by the agent
+struct AgentObservation
+{
+    std::uint64_t tick;    // Ticks since the episode started
+    std::uint32_t episode;
+    std::uint32_t done;       // Snake died, only a reset action moves on
+    std::uint32_t deathCause; // DeathCause value
+    std::uint32_t direction;  // Current moveDirection
+    std::int32_t score;
+    std::uint32_t ate;        // Food was eaten this tick
+    std::uint32_t wallClearance; // Chessboard distance in tiles from the head to the nearest wall, saturating at 255
+    AgentPoint head;
+    AgentPoint food;
+    std::uint32_t bodyLength; // Real length, bodyStored may be less
+    std::uint32_t bodyStored;
+    AgentPoint body[AGENT_MAX_BODY]; // Tail segments, nearest to the head first
+};
+
+// The static walls, written once before the first observation
+struct AgentMap
+{
+    std::uint32_t columns;
+    std::uint32_t rows;
+    float tileSize;                          // Pixels, tile (x, y) covers [x, x + 1) * tileSize
+    std::uint8_t walls[AGENT_MAX_MAP_TILES]; // Row major, 1 for a wall
+};
+
+// Written by the agent once per observation
+struct AgentAction
+{
+    std::uint32_t direction;
+    std::uint32_t reset; // Start a new episode
+    std::uint32_t seed;  // Food seed for the new episode
+    std::uint32_t padding;
+};
+
+// Lockstep handshake: the game publishes observation n into ring[n % AGENT_RING_SIZE] and bumps
+// `published` to n + 1, the agent answers by writing the action and bumping `acted` to n + 1.
+// Both counters are futex words; a side only enters the kernel to wake the other if it is asleep.
+struct AgentSegment
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t ringSize;
+    std::uint32_t maxBody;
+    std::atomic<std::uint32_t> closed;
+
+    alignas(64) std::atomic<std::uint32_t> published;
+    std::atomic<std::uint32_t> observationWaiters;
+
+    alignas(64) std::atomic<std::uint32_t> acted;
+    std::atomic<std::uint32_t> actionWaiters;
+    AgentAction action;
+
+    alignas(64) AgentObservation ring[AGENT_RING_SIZE];
+
+    alignas(64) AgentMap map;
+};
+
+class AgentLink
+{
+public:
+    AgentLink() = default;
+    ~AgentLink();
+
+    AgentLink(const AgentLink &) = delete;
+    AgentLink &operator=(const AgentLink &) = delete;
+
+    // Game side
+    bool create();
+    AgentObservation &nextObservation();
+    void publish();
+    bool waitForAction(AgentAction &action);
+
+    // Agent side
+    bool attach();
+    const AgentObservation *waitForObservation();
+    void act(const AgentAction &action);
+
+    // Either side: the walls, filled in by the game before its first publish
+    AgentMap &getMap() { return segment->map; }
+
+    // Either side: tell the other one to stop waiting
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+
+private:
+    bool waitUntil(std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters, std::uint32_t target, int event);
+    void wake(std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters, int event);
+    void openEvents(bool create);
+    void closeEvents();
+
+    SharedMemory memory;
+    AgentSegment *segment = nullptr;
+    std::uint32_t next = 0; // Observation this side is working on
+    void *events[2] = {nullptr, nullptr};
+};
+
+// Headless game loop driven by an agent through the link, returns the process exit code
+int runAgentServer();
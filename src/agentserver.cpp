@@ -0,0 +1,153 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+
+#include "agentlink.hpp"
+#include "game.hpp"
+#include "player.hpp"
+#include "input.hpp"
+#include "sim.hpp"
+
+namespace
+{
+    // Everything the game keeps for one PLAYING run
+    struct Episode
+    {
+        Player player;
+        Food food;
+        TurnQueue turns;
+        moveDirection direction = moveDirection::Right;
+        std::uint64_t tick = 0;
+        std::int32_t score = 0;
+        TickResult last;
+    };
+
+    void startEpisode(Episode &episode, const TileMap &map, std::uint32_t seed)
+    {
+        episode.player = Player();
+        episode.food.rng.reseed(seed);
+        episode.food.spawn(episode.player, map);
+        episode.turns.clear();
+        episode.direction = moveDirection::Right;
+        episode.tick = 0;
+        episode.score = 0;
+        episode.last = TickResult();
+    }
+
+    static_assert(MAP_COLUMNS * MAP_ROWS <= AGENT_MAX_MAP_TILES, "the agent segment can't hold the map");
+
+    void publishMap(const TileMap &map, AgentMap &out)
+    {
+        out.columns = static_cast<std::uint32_t>(map.getColumns());
+        out.rows = static_cast<std::uint32_t>(map.getRows());
+        out.tileSize = MAP_TILE_SIZE;
+        for (int y = 0; y < map.getRows(); ++y)
+            for (int x = 0; x < map.getColumns(); ++x)
+                out.walls[y * map.getColumns() + x] = map.isWall(x, y) ? 1 : 0;
+    }
+
+    void observe(const Episode &episode, const TileMap &map, std::uint32_t episodeIndex, AgentObservation &observation)
+    {
+        const Player &player = episode.player;
+
+        observation.tick = episode.tick;
+        observation.episode = episodeIndex;
+        observation.done = episode.last.death != DeathCause::None;
+        observation.deathCause = static_cast<std::uint32_t>(episode.last.death);
+        observation.direction = static_cast<std::uint32_t>(episode.direction);
+        observation.score = episode.score;
+        observation.ate = episode.last.ate;
+        observation.wallClearance = static_cast<std::uint32_t>(map.clearanceAt(player.getSimPosition()));
+        const sf::Vector2f head = toPixels(player.getSimPosition());
+        const sf::Vector2f foodPosition = toPixels(episode.food.getSimPosition());
+        observation.head = {head.x, head.y};
+        observation.food = {foodPosition.x, foodPosition.y};
+
+        // Straight from the packed tail copy, no per-segment shape access
+        const std::size_t length = player.tailPositions.size();
+        const std::size_t stored = std::min<std::size_t>(length, AGENT_MAX_BODY);
+        observation.bodyLength = static_cast<std::uint32_t>(length);
+        observation.bodyStored = static_cast<std::uint32_t>(stored);
+        for (std::size_t i = 0; i < stored; ++i)
+        {
+            const sf::Vector2f segment = toPixels(player.tailPositions[i]);
+            observation.body[i] = {segment.x, segment.y};
+        }
+    }
+}
+
+int runAgentServer()
+{
+    AgentLink link;
+    if (!link.create())
+    {
+        std::cerr << "Could not create the agent segment" << std::endl;
+        return 1;
+    }
+    std::cout << "Waiting for an agent on shared memory \"" AGENT_SEGMENT_NAME "\"" << std::endl;
+
+    // The shipped walls, described once in the segment, the clearance comes with every observation
+    TileMap map(MAP_COLUMNS, MAP_ROWS);
+    map.loadFromFile(MAP_FILE);
+    publishMap(map, link.getMap());
+
+    Episode episode;
+    std::uint32_t episodeIndex = 0;
+    startEpisode(episode, map, std::random_device{}());
+
+    std::uint64_t totalTicks = 0;
+    bool started = false;
+    std::chrono::steady_clock::time_point startTime;
+
+    while (true)
+    {
+        observe(episode, map, episodeIndex, link.nextObservation());
+        link.publish();
+
+        AgentAction action;
+        if (!link.waitForAction(action))
+            break;
+
+        if (!started)
+        {
+            started = true;
+            startTime = std::chrono::steady_clock::now();
+        }
+
+        if (action.reset != 0)
+        {
+            startEpisode(episode, map, action.seed);
+            episodeIndex++;
+            continue;
+        }
+
+        // A finished episode only moves on with a reset
+        if (episode.last.death != DeathCause::None)
+            continue;
+
+        // Same turn rules as the keyboard
+        if (action.direction < AGENT_ACTION_KEEP)
+            episode.turns.push(static_cast<moveDirection>(action.direction), episode.direction, sf::Time::Zero);
+
+        PendingTurn turn;
+        if (episode.turns.popReady(episode.direction, episode.player.framesSinceTurn, 2 * framesPerSegment, turn))
+            episode.direction = turn.direction;
+
+        advanceTick(episode.player, episode.direction);
+        episode.last = checkTick(episode.player, episode.food, map);
+        if (episode.last.ate)
+            episode.score += 10;
+
+        episode.tick++;
+        totalTicks++;
+    }
+
+    if (started)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "Agent detached after " << totalTicks << " ticks in " << episodeIndex + 1 << " episodes ("
+                  << static_cast<std::uint64_t>(totalTicks / std::max(seconds, 1e-9)) << " ticks/s)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+
+#include "game.hpp"
+
+// "main --alloccheck [episodes]": plays autopilot runs through the real PLAYING frame, input,
+// sim, drawing into the offscreen texture, audio and stats, and fails when a warmed-up frame
+// that didn't grow anything touched the heap under any tag. Every other run is in practice
+// mode so the rewind recording is covered too. A run ends where the snake dies, the game over
+// screen would write the high score and drop the save.
+
+namespace
+{
+    constexpr std::uint64_t maxFramesPerEpisode = 20000;
+    constexpr int reportedFrames = 5;
+}
+
+int Game::runAllocCheck(int episodes)
+{
+    if (!offscreenMode)
+        return 1;
+
+    std::uint64_t steadyFrames = 0;
+    std::uint64_t allocatingFrames = 0;
+    autopilotEnabled = true;
+
+    for (int episode = 0; episode < episodes; ++episode)
+    {
+        // As resetGame and the PLAYING transition do it, without the save, the session log or music
+        resetPlayfield();
+        food.rng.reseed(static_cast<std::uint32_t>(episode + 1));
+        food.spawn(player, map);
+        heatmapRun.clear();
+        heatmapRun.foodSpawned(food.getSimPosition(), player.getSimPosition());
+        ghostRecording.clear();
+        ghostRecordingLive = true;
+        practiceMode = episode % 2 == 1;
+        if (practiceMode)
+            rewind.start(player, food, direction, scoreboard.getCurrentScore());
+        else
+            rewind.stop();
+        rewindHeld = false;
+        playingFrames = 0;
+        currentState = GameState::PLAYING;
+        stateChanged = false;
+
+        std::uint64_t frame = 0;
+        for (; frame < maxFramesPerEpisode && currentState == GameState::PLAYING && !stateChanged && !dying; ++frame)
+        {
+            runFrame();
+            if (playingFrames < ALLOC_WARMUP_FRAMES || frameGrew || dying || rewindHeld)
+                continue;
+
+            steadyFrames++;
+            if (frameAllocs.total() == 0)
+                continue;
+
+            if (allocatingFrames < reportedFrames)
+            {
+                std::cerr << "alloccheck: run " << episode << " frame " << frame << " made";
+                for (std::size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag)
+                    std::cerr << " " << allocTagName(static_cast<AllocTag>(tag)) << " " << frameAllocs.allocations[tag];
+                std::cerr << '\n';
+            }
+            allocatingFrames++;
+        }
+
+        std::cout << "run " << episode << (practiceMode ? " (practice)" : "") << ": " << frame << " frames, "
+                  << player.tailSegments.size() << " segments\n";
+    }
+
+    std::cout << steadyFrames << " steady frames, " << allocatingFrames << " allocated\n";
+    return allocatingFrames == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloccount.hpp"
+
+// Replaces the global operator new/delete so every heap allocation in the game is counted.
+// Over-aligned allocations keep the library versions and are not counted.
+
+namespace
+{
+    std::atomic<std::uint64_t> allocationCount[ALLOC_TAG_COUNT];
+    std::atomic<std::uint64_t> allocationBytes[ALLOC_TAG_COUNT];
+    thread_local AllocTag currentTag = AllocTag::Other;
+
+    void *allocate(std::size_t size)
+    {
+        std::size_t tag = static_cast<std::size_t>(currentTag);
+        allocationCount[tag].fetch_add(1, std::memory_order_relaxed);
+        allocationBytes[tag].fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0)
+            size = 1;
+        while (true)
+        {
+            if (void *memory = std::malloc(size))
+                return memory;
+
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    std::free(memory);
+}
+
+std::uint64_t AllocCounts::total() const
+{
+    std::uint64_t sum = 0;
+    for (std::uint64_t count : allocations)
+        sum += count;
+    return sum;
+}
+
+AllocCounts allocCounts()
+{
+    AllocCounts counts;
+    for (std::size_t i = 0; i < ALLOC_TAG_COUNT; ++i)
+    {
+        counts.allocations[i] = allocationCount[i].load(std::memory_order_relaxed);
+        counts.bytes[i] = allocationBytes[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+AllocCounts operator-(const AllocCounts &later, const AllocCounts &earlier)
+{
+    AllocCounts delta;
+    for (std::size_t i = 0; i < ALLOC_TAG_COUNT; ++i)
+    {
+        delta.allocations[i] = later.allocations[i] - earlier.allocations[i];
+        delta.bytes[i] = later.bytes[i] - earlier.bytes[i];
+    }
+    return delta;
+}
+
+const char *allocTagName(AllocTag tag)
+{
+    static const char *names[] = {"other", "input", "sim", "autopilot", "render", "audio", "overlay"};
+    std::size_t index = static_cast<std::size_t>(tag);
+    return index < ALLOC_TAG_COUNT ? names[index] : "?";
+}
+
+AllocScope::AllocScope(AllocTag tag)
+    : previous(currentTag)
+{
+    currentTag = tag;
+}
+
+AllocScope::~AllocScope()
+{
+    currentTag = previous;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Subsystem an allocation is charged to, set per thread with AllocScope
+enum class AllocTag
+{
+    Other,
+    Input,
+    Sim,
+    Autopilot,
+    Render,
+    Audio,
+    Overlay,
+    Count
+};
+
+#define ALLOC_TAG_COUNT static_cast<std::size_t>(AllocTag::Count)
+
+// Heap allocations made through operator new, every thread, since start-up
+struct AllocCounts
+{
+    std::uint64_t allocations[ALLOC_TAG_COUNT] = {};
+    std::uint64_t bytes[ALLOC_TAG_COUNT] = {};
+
+    std::uint64_t operator[](AllocTag tag) const { return allocations[static_cast<std::size_t>(tag)]; }
+    std::uint64_t total() const;
+};
+
+AllocCounts allocCounts();
+AllocCounts operator-(const AllocCounts &later, const AllocCounts &earlier);
+const char *allocTagName(AllocTag tag);
+
+// Charges allocations on this thread to a subsystem until it goes out of scope
+class AllocScope
+{
+public:
+    explicit AllocScope(AllocTag tag);
+    ~AllocScope();
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+
+private:
+    AllocTag previous;
+};
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "arena.hpp"
+
+namespace
+{
+    constexpr int directionX[4] = {0, 1, 0, -1};
+    constexpr int directionY[4] = {-1, 0, 1, 0};
+    constexpr size_t startLength = 4;
+    constexpr size_t snakesPerChunk = 64;
+}
+
+Arena::Arena(int width, int height, JobSystem &jobs)
+    : width(width), height(height), jobs(jobs),
+      bodyOwner(static_cast<size_t>(width) * height, 0),
+      foodAt(static_cast<size_t>(width) * height, 0),
+      headClaims(new std::atomic<std::uint8_t>[static_cast<size_t>(width) * height])
+{
+    for (size_t i = 0; i < bodyOwner.size(); ++i)
+        headClaims[i].store(0, std::memory_order_relaxed);
+}
+
+sf::Vector2f Arena::getWorldSize() const
+{
+    return {width * ARENA_CELL_SIZE, height * ARENA_CELL_SIZE};
+}
+
+std::uint32_t Arena::nextRandom(std::uint32_t &state)
+{
+    // xorshift32, cheap and private to each snake so threads never share RNG state
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+std::int32_t Arena::randomFreeCell(std::uint32_t &rngState) const
+{
+    const std::uint32_t cellCount = static_cast<std::uint32_t>(bodyOwner.size());
+    for (int attempt = 0; attempt < 64; ++attempt)
+    {
+        std::uint32_t cell = nextRandom(rngState) % cellCount;
+        if (bodyOwner[cell] == 0 && foodAt[cell] == 0)
+            return static_cast<std::int32_t>(cell);
+    }
+    return -1;
+}
+
+void Arena::reset(size_t snakeCount, std::uint32_t seed)
+{
+    std::fill(bodyOwner.begin(), bodyOwner.end(), 0);
+    std::fill(foodAt.begin(), foodAt.end(), 0);
+    worldRng = seed ? seed : 1;
+    tickCount = 0;
+
+    foodCells.assign(std::max<size_t>(snakeCount / 2, 1), -1);
+    for (std::uint32_t i = 0; i < foodCells.size(); ++i)
+        respawnFood(i);
+
+    snakes.assign(snakeCount, ArenaSnake{});
+    for (std::uint32_t i = 0; i < snakes.size(); ++i)
+    {
+        ArenaSnake &snake = snakes[i];
+        snake.rngState = nextRandom(worldRng) | 1u;
+        snake.color = sf::Color(static_cast<std::uint8_t>(64 + nextRandom(worldRng) % 192),
+                                static_cast<std::uint8_t>(64 + nextRandom(worldRng) % 192),
+                                static_cast<std::uint8_t>(64 + nextRandom(worldRng) % 192));
+        respawnSnake(i);
+    }
+}
+
+void Arena::respawnFood(std::uint32_t index)
+{
+    if (foodCells[index] >= 0)
+        foodAt[foodCells[index]] = 0;
+
+    foodCells[index] = randomFreeCell(worldRng);
+    if (foodCells[index] >= 0)
+        foodAt[foodCells[index]] = index + 1;
+}
+
+void Arena::respawnSnake(std::uint32_t id)
+{
+    ArenaSnake &snake = snakes[id];
+
+    for (std::int32_t cell : snake.body)
+        bodyOwner[cell] = 0;
+    snake.body.clear();
+    snake.dead = false;
+
+    // Lay the new body out straight behind the head; give up and stay dormant if the arena is packed
+    std::int32_t head = randomFreeCell(snake.rngState);
+    if (head < 0)
+    {
+        snake.dead = true;
+        return;
+    }
+
+    snake.direction = static_cast<std::int32_t>(nextRandom(snake.rngState) % 4);
+    snake.targetFood = nextRandom(snake.rngState) % static_cast<std::uint32_t>(foodCells.size());
+
+    int x = head % width;
+    int y = head / width;
+    for (size_t i = 0; i < startLength; ++i)
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            break;
+        std::int32_t cell = y * width + x;
+        if (bodyOwner[cell] != 0 || foodAt[cell] != 0)
+            break;
+        snake.body.push_back(cell);
+        bodyOwner[cell] = id + 1;
+        x -= directionX[snake.direction];
+        y -= directionY[snake.direction];
+    }
+}
+
+void Arena::think(ArenaSnake &snake)
+{
+    snake.nextCell = -1;
+    if (snake.dead)
+        return;
+
+    int headX = snake.body.front() % width;
+    int headY = snake.body.front() / width;
+
+    std::int32_t target = foodCells[snake.targetFood];
+    int targetX = target >= 0 ? target % width : width / 2;
+    int targetY = target >= 0 ? target / width : height / 2;
+
+    // Greedy: of straight/left/right, take the free cell closest to the target food.
+    // Every body cell, tails included, counts as blocked so moves never depend on update order.
+    int bestDistance = 0;
+    int bestDirection = -1;
+    std::uint32_t jitter = nextRandom(snake.rngState);
+    for (int turn = 0; turn < 3; ++turn)
+    {
+        int direction = (snake.direction + 3 + static_cast<int>((turn + jitter) % 3)) % 4;
+        int x = headX + directionX[direction];
+        int y = headY + directionY[direction];
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            continue;
+        if (bodyOwner[y * width + x] != 0)
+            continue;
+
+        int distance = std::abs(targetX - x) + std::abs(targetY - y);
+        if (bestDirection < 0 || distance < bestDistance)
+        {
+            bestDistance = distance;
+            bestDirection = direction;
+        }
+    }
+
+    if (bestDirection < 0)
+        return;
+
+    snake.direction = bestDirection;
+    snake.nextCell = (headY + directionY[bestDirection]) * width + headX + directionX[bestDirection];
+    headClaims[snake.nextCell].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Arena::tick()
+{
+    // Phase 1 (parallel): every snake picks its next cell and claims it
+    jobs.parallelFor(snakes.size(), snakesPerChunk, [this](size_t begin, size_t end)
+                     {
+        for (size_t i = begin; i < end; ++i)
+            think(snakes[i]); });
+
+    // Phase 2 (parallel): two heads claiming the same cell is a head-on crash for both
+    jobs.parallelFor(snakes.size(), snakesPerChunk, [this](size_t begin, size_t end)
+                     {
+        for (size_t i = begin; i < end; ++i)
+        {
+            ArenaSnake &snake = snakes[i];
+            if (!snake.dead && (snake.nextCell < 0 || headClaims[snake.nextCell].load(std::memory_order_relaxed) > 1))
+                snake.dead = true;
+        } });
+
+    // Phase 3 (serial, fixed order): apply moves, eat food and recycle dead snakes.
+    // This is O(snakes) with O(1) work each, so the result is deterministic for any thread count.
+    for (std::uint32_t i = 0; i < snakes.size(); ++i)
+    {
+        ArenaSnake &snake = snakes[i];
+        if (snake.nextCell >= 0)
+            headClaims[snake.nextCell].store(0, std::memory_order_relaxed);
+
+        if (snake.dead)
+            continue;
+
+        std::int32_t cell = snake.nextCell;
+        snake.body.push_front(cell);
+        bodyOwner[cell] = i + 1;
+
+        if (foodAt[cell] != 0)
+        {
+            std::uint32_t eaten = foodAt[cell] - 1;
+            respawnFood(eaten);
+            snake.targetFood = nextRandom(snake.rngState) % static_cast<std::uint32_t>(foodCells.size());
+        }
+        else
+        {
+            bodyOwner[snake.body.back()] = 0;
+            snake.body.pop_back();
+        }
+    }
+
+    // Respawn only once all moves are applied, so a new body can't land on a cell someone just claimed
+    for (std::uint32_t i = 0; i < snakes.size(); ++i)
+        if (snakes[i].dead)
+            respawnSnake(i);
+
+    // Food that found no free cell tries again every tick, like a dormant snake
+    for (std::uint32_t i = 0; i < foodCells.size(); ++i)
+        if (foodCells[i] < 0)
+            respawnFood(i);
+
+    ++tickCount;
+}
+
+void Arena::buildVertices(sf::VertexArray &vertices) const
+{
+    vertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+    vertices.clear();
+
+    auto addCell = [&](std::int32_t cell, sf::Color color)
+    {
+        float left = (cell % width) * ARENA_CELL_SIZE;
+        float top = (cell / width) * ARENA_CELL_SIZE;
+        float right = left + ARENA_CELL_SIZE;
+        float bottom = top + ARENA_CELL_SIZE;
+
+        vertices.append({{left, top}, color});
+        vertices.append({{right, top}, color});
+        vertices.append({{right, bottom}, color});
+        vertices.append({{left, top}, color});
+        vertices.append({{right, bottom}, color});
+        vertices.append({{left, bottom}, color});
+    };
+
+    for (std::int32_t cell : foodCells)
+        if (cell >= 0)
+            addCell(cell, sf::Color::Red);
+
+    for (const auto &snake : snakes)
+        for (std::int32_t cell : snake.body)
+            addCell(cell, snake.color);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "jobs.hpp"
+
+#define ARENA_CELL_SIZE 4.0f
+#define ARENA_WIDTH 480  // Cells
+#define ARENA_HEIGHT 270 // Cells
+#define ARENA_START_SNAKES 1024
+#define ARENA_MAX_SNAKES 16384
+#define ARENA_MIN_SNAKES 16
+
+// Many AI snakes on a shared cell grid, used as a spectator attract mode and scaling test
+class Arena
+{
+public:
+    Arena(int width, int height, JobSystem &jobs);
+
+    void reset(size_t snakeCount, std::uint32_t seed);
+    void tick();
+    void buildVertices(sf::VertexArray &vertices) const;
+
+    size_t getSnakeCount() const { return snakes.size(); }
+    std::uint64_t getTickCount() const { return tickCount; }
+    sf::Vector2f getWorldSize() const;
+
+private:
+    struct ArenaSnake
+    {
+        std::deque<std::int32_t> body; // Cell indices, head first
+        std::int32_t nextCell = -1;
+        std::int32_t direction = 0;    // 0 up, 1 right, 2 down, 3 left
+        std::uint32_t targetFood = 0;
+        std::uint32_t rngState = 1;
+        bool dead = false;
+        sf::Color color;
+    };
+
+    void think(ArenaSnake &snake);
+    void respawnSnake(std::uint32_t id);
+    void respawnFood(std::uint32_t index);
+    std::int32_t randomFreeCell(std::uint32_t &rngState) const;
+    static std::uint32_t nextRandom(std::uint32_t &state);
+
+    int width;
+    int height;
+    JobSystem &jobs;
+
+    std::vector<ArenaSnake> snakes;
+    std::vector<std::int32_t> foodCells;
+
+    // Broad phase shared by all snakes: one entry per cell
+    std::vector<std::uint32_t> bodyOwner; // 0 = empty, otherwise snake index + 1
+    std::vector<std::uint32_t> foodAt;    // 0 = empty, otherwise food index + 1
+    std::unique_ptr<std::atomic<std::uint8_t>[]> headClaims;
+
+    std::uint32_t worldRng = 1;
+    std::uint64_t tickCount = 0;
+};
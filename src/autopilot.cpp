@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+
+#include "autopilot.hpp"
+#include "player.hpp"
+#include "tilemap.hpp"
+
+namespace
+{
+    // Cells are one segment wide and centered on multiples of the segment size, the grid the
+    // head is on every framesPerCell frames
+    constexpr SimCoord cellSize = toSim(PLAYER_SIZE);
+    constexpr int minFramesBetweenTurns = 2 * framesPerSegment;
+
+    constexpr int stepX[4] = {0, 0, -1, 1}; // Indexed by moveDirection
+    constexpr int stepY[4] = {-1, 1, 0, 0};
+
+    bool opposite(int a, int b)
+    {
+        return (a ^ b) == 1; // Up/Down and Left/Right differ only in the lowest bit
+    }
+
+    // Turn readiness at a cell center: 0 = needs two more straight cells, 1 = needs one, 2 = may turn.
+    // A turn leaves the snake at 1 on the next center (framesPerCell < minFramesBetweenTurns).
+    constexpr int turnLevels = 3;
+    constexpr int statesPerCell = 4 * turnLevels;
+
+    int turnLevel(int framesSinceTurn)
+    {
+        if (framesSinceTurn >= minFramesBetweenTurns)
+            return 2;
+        return framesSinceTurn + framesPerCell >= minFramesBetweenTurns ? 1 : 0;
+    }
+
+    int stateIndex(std::int32_t cell, int direction, int level)
+    {
+        return (cell * 4 + direction) * turnLevels + level;
+    }
+
+    std::int32_t stateCell(int state) { return state / statesPerCell; }
+    int stateDirection(int state) { return (state / turnLevels) % 4; }
+    int stateLevel(int state) { return state % turnLevels; }
+
+    // Rounds toward negative infinity, positions can be slightly outside the world
+    SimCoord floorDiv(SimCoord value, SimCoord divisor)
+    {
+        SimCoord quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+}
+
+Autopilot::Autopilot(sf::Vector2f worldSize)
+    : columns(static_cast<int>(worldSize.x / PLAYER_SIZE) + 1),
+      rows(static_cast<int>(worldSize.y / PLAYER_SIZE) + 1),
+      staticCells(static_cast<size_t>(columns) * rows, 0),
+      clearance(static_cast<size_t>(columns) * rows, 255),
+      blockedUntil(static_cast<size_t>(columns) * rows, 0)
+{
+    // Cells whose center is within half a snake of the world edge are walls
+    for (int x = 0; x < columns; ++x)
+    {
+        staticCells[x] = 1;
+        staticCells[(rows - 1) * columns + x] = 1;
+    }
+    for (int y = 0; y < rows; ++y)
+    {
+        staticCells[y * columns] = 1;
+        staticCells[y * columns + columns - 1] = 1;
+    }
+
+    const size_t states = blockedUntil.size() * statesPerCell;
+    cost.resize(states);
+    parent.resize(states);
+    visited.resize(states, 0);
+    open.reserve(states);
+    path.reserve(blockedUntil.size());
+}
+
+void Autopilot::reset()
+{
+    path.clear();
+    goalCell = -1;
+    stats = AutopilotStats();
+}
+
+void Autopilot::setMap(const TileMap &map)
+{
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < columns; ++x)
+        {
+            const SimVector center{x * cellSize, y * cellSize};
+            const std::int32_t cell = y * columns + x;
+            bool border = x == 0 || y == 0 || x == columns - 1 || y == rows - 1;
+            staticCells[cell] = border || map.overlapsWall(center, cellSize / 2);
+            clearance[cell] = static_cast<std::uint8_t>(map.clearanceAt(center));
+        }
+    }
+    path.clear();
+    goalCell = -1;
+}
+
+std::int32_t Autopilot::cellAt(SimVector position) const
+{
+    int x = std::clamp(floorDiv(position.x + cellSize / 2, cellSize), 0, columns - 1);
+    int y = std::clamp(floorDiv(position.y + cellSize / 2, cellSize), 0, rows - 1);
+    return y * columns + x;
+}
+
+void Autopilot::buildObstacles(const Player &player)
+{
+    for (size_t i = 0; i < blockedUntil.size(); ++i)
+        blockedUntil[i] = staticCells[i] ? INT_MAX : 0;
+
+    // Segment i is followed through its cell by every later segment, so the cell stays
+    // taken until the last one has left it. Frozen segments sit still for their freeze time.
+    const int count = static_cast<int>(player.tailSegments.size());
+    for (int i = 0; i < count; ++i)
+    {
+        const Tail &segment = player.tailSegments[i];
+        int steps = count - i;
+        if (segment.isFrozen)
+            steps += (segment.freezeFrames + framesPerCell - 1) / framesPerCell;
+
+        // A segment off the grid overlaps up to four cells
+        SimVector position = player.tailPositions[i];
+        int x0 = floorDiv(position.x, cellSize);
+        int y0 = floorDiv(position.y, cellSize);
+        for (int y = y0; y <= y0 + 1; ++y)
+        {
+            for (int x = x0; x <= x0 + 1; ++x)
+            {
+                if (x < 0 || y < 0 || x >= columns || y >= rows)
+                    continue;
+                if (std::abs(x * cellSize - position.x) >= cellSize || std::abs(y * cellSize - position.y) >= cellSize)
+                    continue;
+                std::int32_t cell = y * columns + x;
+                blockedUntil[cell] = std::max(blockedUntil[cell], steps);
+            }
+        }
+    }
+}
+
+bool Autopilot::isFreeAt(std::int32_t cell, int step) const
+{
+    return blockedUntil[cell] < step;
+}
+
+size_t Autopilot::firstBrokenStep() const
+{
+    for (size_t i = 0; i < path.size(); ++i)
+    {
+        if (!isFreeAt(path[i].cell, static_cast<int>(i) + 1))
+            return i;
+    }
+    return path.size();
+}
+
+bool Autopilot::searchFrom(std::int32_t startCell, int startDirection, int startLevel, int startStep, std::chrono::steady_clock::time_point deadline,
+                           std::vector<PathStep> &out)
+{
+    const int goalX = goalCell % columns;
+    const int goalY = goalCell / columns;
+    auto heuristic = [&](std::int32_t cell)
+    {
+        return std::abs(cell % columns - goalX) + std::abs(cell / columns - goalY);
+    };
+
+    // Open list entries pack (f, state) into one integer so the heap compares plain numbers
+    auto push = [&](int f, int state)
+    {
+        open.push_back((static_cast<std::uint64_t>(f) << 32) | static_cast<std::uint32_t>(state));
+        std::push_heap(open.begin(), open.end(), std::greater<std::uint64_t>());
+    };
+
+    if (++searchStamp == 0)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        searchStamp = 1;
+    }
+    open.clear();
+
+    int start = stateIndex(startCell, startDirection, startLevel);
+    visited[start] = searchStamp;
+    cost[start] = startStep;
+    parent[start] = -1;
+    push(startStep + heuristic(startCell), start);
+
+    int found = -1;
+    int closest = start;
+    int expanded = 0;
+    bool outOfBudget = false;
+
+    while (!open.empty())
+    {
+        std::pop_heap(open.begin(), open.end(), std::greater<std::uint64_t>());
+        int state = static_cast<int>(open.back() & 0xFFFFFFFFu);
+        int f = static_cast<int>(open.back() >> 32);
+        open.pop_back();
+
+        std::int32_t cell = stateCell(state);
+        if (f > cost[state] + heuristic(cell))
+            continue; // Stale entry
+
+        // Reaching the food is only useful if the snake can still go somewhere afterwards
+        if (cell == goalCell && hasExit(state, cost[state]))
+        {
+            found = state;
+            break;
+        }
+        if (heuristic(cell) < heuristic(stateCell(closest)))
+            closest = state;
+
+        if (++expanded >= AUTOPILOT_NODE_BUDGET ||
+            ((expanded & 255) == 0 && std::chrono::steady_clock::now() > deadline))
+        {
+            outOfBudget = true;
+            break;
+        }
+
+        int direction = stateDirection(state);
+        int level = stateLevel(state);
+        int x = cell % columns;
+        int y = cell / columns;
+        int step = cost[state] + 1;
+
+        for (int next = 0; next < 4; ++next)
+        {
+            bool turning = next != direction;
+            if (opposite(next, direction) || (turning && level < 2))
+                continue;
+
+            int nx = x + stepX[next];
+            int ny = y + stepY[next];
+            if (nx < 0 || ny < 0 || nx >= columns || ny >= rows)
+                continue;
+
+            std::int32_t nextCell = ny * columns + nx;
+            if (!isFreeAt(nextCell, step))
+                continue;
+
+            int nextState = stateIndex(nextCell, next, turning ? 1 : std::min(level + 1, 2));
+            if (visited[nextState] == searchStamp && cost[nextState] <= step)
+                continue;
+
+            visited[nextState] = searchStamp;
+            cost[nextState] = step;
+            parent[nextState] = state;
+            push(step + heuristic(nextCell), nextState);
+        }
+    }
+
+    stats.lastExpanded += expanded;
+    if (outOfBudget)
+        stats.budgetHits++;
+
+    // Out of budget: head for the explored state nearest the food and continue next decision
+    int target = found >= 0 ? found : (outOfBudget ? closest : -1);
+    if (target < 0 || target == start)
+        return false;
+
+    size_t first = out.size();
+    for (int state = target; state != start; state = parent[state])
+        out.push_back({stateCell(state), static_cast<std::uint8_t>(stateDirection(state)), static_cast<std::uint8_t>(stateLevel(state))});
+    std::reverse(out.begin() + first, out.end());
+    return true;
+}
+
+bool Autopilot::hasExit(int state, int step) const
+{
+    std::int32_t cell = stateCell(state);
+    int direction = stateDirection(state);
+    bool canTurn = stateLevel(state) == 2;
+    int x = cell % columns;
+    int y = cell / columns;
+
+    for (int next = 0; next < 4; ++next)
+    {
+        if (opposite(next, direction) || (next != direction && !canTurn))
+            continue;
+        int nx = x + stepX[next];
+        int ny = y + stepY[next];
+        if (nx >= 0 && ny >= 0 && nx < columns && ny < rows && isFreeAt(ny * columns + nx, step + 1))
+            return true;
+    }
+    return false;
+}
+
+bool Autopilot::safeFallback(std::int32_t head, int direction, bool canTurn, moveDirection &next) const
+{
+    // Any move that doesn't run into something next step, the one furthest from the walls,
+    // straight ahead when that is as good as a turn
+    int x = head % columns;
+    int y = head / columns;
+    int best = -1;
+    for (int candidate : {direction, 0, 1, 2, 3})
+    {
+        if (opposite(candidate, direction) || (candidate != direction && !canTurn))
+            continue;
+        int nx = x + stepX[candidate];
+        int ny = y + stepY[candidate];
+        if (nx < 0 || ny < 0 || nx >= columns || ny >= rows || !isFreeAt(ny * columns + nx, 1))
+            continue;
+        if (clearance[ny * columns + nx] > best)
+        {
+            best = clearance[ny * columns + nx];
+            next = static_cast<moveDirection>(candidate);
+        }
+    }
+    return best >= 0;
+}
+
+bool Autopilot::decide(const Player &player, const Food &food, moveDirection current, moveDirection &next)
+{
+    // Decisions happen when the moving axis crosses a cell center, that's where turns can land on the grid
+    SimVector head = player.getSimPosition();
+    SimCoord moving = (current == moveDirection::Up || current == moveDirection::Down) ? head.y : head.x;
+    SimCoord offset = moving - floorDiv(moving, cellSize) * cellSize;
+    if (std::min(offset, cellSize - offset) > toSim(PLAYER_SPEED) / 2)
+        return false;
+
+    // One deadline for everything below, a failed repair doesn't start the budget over
+    sf::Clock clock;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(AUTOPILOT_TIME_BUDGET_US);
+    stats.decisions++;
+    stats.lastExpanded = 0;
+
+    buildObstacles(player);
+
+    const std::int32_t headCell = cellAt(head);
+    const int direction = static_cast<int>(current);
+    const int level = turnLevel(player.framesSinceTurn);
+    const std::int32_t foodCell = cellAt(food.getSimPosition());
+
+    // The head should now be in the first cell of the kept path, anything else means we left it
+    if (!path.empty() && path.front().cell == headCell && path.front().direction == direction && path.front().level == level)
+        path.erase(path.begin());
+    else
+        path.clear();
+
+    bool planned = false;
+    if (foodCell == goalCell && !path.empty())
+    {
+        size_t broken = firstBrokenStep();
+        if (broken == path.size())
+        {
+            planned = true;
+        }
+        else if (broken > 0)
+        {
+            // Repair: keep the good prefix and search again from its last step
+            const PathStep last = path[broken - 1];
+            path.resize(broken);
+            planned = searchFrom(last.cell, last.direction, last.level, static_cast<int>(broken), deadline, path);
+            if (planned)
+                stats.repairs++;
+        }
+    }
+
+    if (!planned)
+    {
+        goalCell = foodCell;
+        path.clear();
+        if (std::chrono::steady_clock::now() < deadline)
+        {
+            planned = searchFrom(headCell, direction, level, 0, deadline, path);
+            stats.fullPlans++;
+        }
+        else
+        {
+            // Nothing left for a replan, the fallback below and another try next decision
+            stats.budgetHits++;
+        }
+    }
+
+    if (planned && !path.empty())
+    {
+        next = static_cast<moveDirection>(path.front().direction);
+    }
+    else
+    {
+        path.clear();
+        if (!safeFallback(headCell, direction, level == 2, next))
+            next = current; // Boxed in, nothing left to do
+    }
+
+    stats.lastCost = clock.getElapsedTime();
+    return true;
+}
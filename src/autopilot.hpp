@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+#include "types.hpp"
+#include "fixedpoint.hpp"
+
+#define AUTOPILOT_NODE_BUDGET 20000   // A* expansions per decision
+#define AUTOPILOT_TIME_BUDGET_US 500  // Hard CPU limit per decision, obstacles, repair and replan together
+
+class Player;
+class Food;
+class TileMap;
+
+struct AutopilotStats
+{
+    int decisions = 0;
+    int fullPlans = 0;
+    int repairs = 0;
+    int budgetHits = 0;
+    int lastExpanded = 0;
+    sf::Time lastCost;
+};
+
+// Steers the snake to the food with a time-aware A* over a grid of segment sized cells.
+// Body cells count as blocked only until the tail has moved out of them, and a path is kept
+// between decisions and repaired from the first broken step instead of replanned every tick.
+class Autopilot
+{
+public:
+    explicit Autopilot(sf::Vector2f worldSize);
+
+    void reset();
+    void setMap(const TileMap &map); // Walls count as blocked forever, clearance breaks ties when cornered
+    // True when the head sits on a cell boundary, with the heading to take from there
+    bool decide(const Player &player, const Food &food, moveDirection current, moveDirection &next);
+    const AutopilotStats &getStats() const { return stats; }
+
+private:
+    struct PathStep
+    {
+        std::int32_t cell;
+        std::uint8_t direction; // Heading while entering the cell
+        std::uint8_t level;     // Turn readiness on arrival
+    };
+
+    void buildObstacles(const Player &player);
+    bool isFreeAt(std::int32_t cell, int step) const;
+    bool searchFrom(std::int32_t cell, int direction, int level, int startStep, std::chrono::steady_clock::time_point deadline,
+                    std::vector<PathStep> &out);
+    size_t firstBrokenStep() const;
+    bool hasExit(int state, int step) const;
+    bool safeFallback(std::int32_t head, int direction, bool canTurn, moveDirection &next) const;
+    std::int32_t cellAt(SimVector position) const;
+
+    int columns;
+    int rows;
+    std::vector<std::uint8_t> staticCells;  // Borders and map walls
+    std::vector<std::uint8_t> clearance;    // Map distance field at each cell center
+    std::vector<std::int32_t> blockedUntil; // Steps until a cell is free, 0 = free now
+    std::vector<PathStep> path;             // Upcoming cells, path[0] is entered next
+    std::int32_t goalCell = -1;
+
+    // Search scratch, reused between decisions so planning doesn't allocate
+    std::vector<std::int32_t> cost;
+    std::vector<std::int32_t> parent;
+    std::vector<std::uint32_t> visited;
+    std::vector<std::uint64_t> open;
+    std::uint32_t searchStamp = 0;
+
+    AutopilotStats stats;
+};
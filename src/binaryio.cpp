@@ -0,0 +1,72 @@
+#include <filesystem>
+#include <fstream>
+
+#include "binaryio.hpp"
+
+std::uint32_t checksum(const char *data, size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putVarint(std::vector<char> &out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putSigned(std::vector<char> &out, std::int64_t value)
+{
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+bool writeFileAtomically(const std::string &filename, const std::vector<char> &bytes)
+{
+    std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFilename, filename, error);
+    return !error;
+}
+
+bool ByteReader::getVarint(std::uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (remaining == 0)
+            return false;
+        unsigned char byte = static_cast<unsigned char>(*data++);
+        remaining--;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool ByteReader::getSigned(std::int64_t &value)
+{
+    std::uint64_t raw;
+    if (!getVarint(raw))
+        return false;
+    value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+    return true;
+}
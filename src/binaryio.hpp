@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Shared by the save, session log and ghost file formats
+
+// FNV-1a
+std::uint32_t checksum(const char *data, size_t size);
+
+// LEB128, small values take one byte
+void putVarint(std::vector<char> &out, std::uint64_t value);
+// Zigzag first, so small negative numbers stay small too
+void putSigned(std::vector<char> &out, std::int64_t value);
+
+// Through a temporary file and a rename, so a crash mid-write never leaves a torn file behind
+bool writeFileAtomically(const std::string &filename, const std::vector<char> &bytes);
+
+// Bounds-checked reads from a buffer, every get fails instead of reading past the end
+class ByteReader
+{
+public:
+    ByteReader(const char *data, size_t size) : data(data), remaining(size) {}
+
+    template <typename T>
+    bool get(T &value)
+    {
+        return getBytes(&value, sizeof(T));
+    }
+
+    bool getBytes(void *dest, size_t size)
+    {
+        if (size > remaining)
+            return false;
+        std::memcpy(dest, data, size);
+        data += size;
+        remaining -= size;
+        return true;
+    }
+
+    // Element counts are validated against the bytes left so a corrupt file can't trigger huge allocations
+    bool getCount(std::uint32_t &count, size_t elementSize)
+    {
+        return get(count) && static_cast<size_t>(count) * elementSize <= remaining;
+    }
+
+    bool getVarint(std::uint64_t &value);
+
+    template <typename T>
+    bool getVarint(T &value)
+    {
+        std::uint64_t wide;
+        if (!getVarint(wide))
+            return false;
+        value = static_cast<T>(wide);
+        return true;
+    }
+
+    bool getSigned(std::int64_t &value);
+
+    bool atEnd() const { return remaining == 0; }
+
+private:
+    const char *data;
+    size_t remaining;
+};
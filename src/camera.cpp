@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+
+#include "camera.hpp"
+
+Camera::Camera(sf::Vector2f viewSize, sf::Vector2f worldSize)
+    : view(viewSize / 2.0f, viewSize), worldSize(worldSize)
+{
+}
+
+void Camera::follow(sf::Vector2f target)
+{
+    // Center on the target but never show anything past the world edges
+    sf::Vector2f half = view.getSize() / 2.0f;
+    sf::Vector2f center;
+    center.x = worldSize.x > 2 * half.x ? std::clamp(target.x, half.x, worldSize.x - half.x) : worldSize.x / 2;
+    center.y = worldSize.y > 2 * half.y ? std::clamp(target.y, half.y, worldSize.y - half.y) : worldSize.y / 2;
+    view.setCenter(center);
+}
+
+bool Camera::isVisible(sf::Vector2f position, float halfSize) const
+{
+    sf::Vector2f center = view.getCenter();
+    sf::Vector2f half = view.getSize() / 2.0f;
+    return std::abs(position.x - center.x) < half.x + halfSize &&
+           std::abs(position.y - center.y) < half.y + halfSize;
+}
+
+sf::FloatRect Camera::getVisibleArea() const
+{
+    return {view.getCenter() - view.getSize() / 2.0f, view.getSize()};
+}
+
+ChunkedBackground::ChunkedBackground(const sf::Texture &texture)
+    : chunk(texture), chunkSize(sf::Vector2i(texture.getSize()))
+{
+}
+
+void ChunkedBackground::draw(sf::RenderTarget &target, const Camera &camera)
+{
+    sf::FloatRect area = camera.getVisibleArea();
+    int firstX = static_cast<int>(std::floor(area.position.x / chunkSize.x));
+    int firstY = static_cast<int>(std::floor(area.position.y / chunkSize.y));
+    int lastX = static_cast<int>(std::floor((area.position.x + area.size.x) / chunkSize.x));
+    int lastY = static_cast<int>(std::floor((area.position.y + area.size.y) / chunkSize.y));
+
+    // Only the few chunks overlapping the view are drawn, whatever the world size
+    for (int y = firstY; y <= lastY; ++y)
+    {
+        for (int x = firstX; x <= lastX; ++x)
+        {
+            chunk.setPosition({static_cast<float>(x * chunkSize.x), static_cast<float>(y * chunkSize.y)});
+            target.draw(chunk);
+        }
+    }
+}
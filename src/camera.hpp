@@ -0,0 +1,34 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// Follows the snake around a world larger than the screen
+class Camera
+{
+public:
+    Camera(sf::Vector2f viewSize, sf::Vector2f worldSize);
+
+    void follow(sf::Vector2f target);
+    void apply(sf::RenderTarget &target) const { target.setView(view); }
+
+    // Square of the given half size centered on position touches the view
+    bool isVisible(sf::Vector2f position, float halfSize) const;
+    sf::FloatRect getVisibleArea() const;
+
+private:
+    sf::View view;
+    sf::Vector2f worldSize;
+};
+
+// Tiles one background texture across the world, only the chunks inside the view get drawn
+class ChunkedBackground
+{
+public:
+    explicit ChunkedBackground(const sf::Texture &texture);
+
+    void draw(sf::RenderTarget &target, const Camera &camera);
+
+private:
+    sf::Sprite chunk;
+    sf::Vector2i chunkSize;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+// Simulation coordinates are 24.8 fixed point pixels. The sim only adds, subtracts and
+// compares them, so its state is bit-identical whatever the compiler, flags or thread count.
+#define SIM_FRACTION_BITS 8
+#define SIM_ONE (1 << SIM_FRACTION_BITS)
+
+using SimCoord = std::int32_t;
+
+struct SimVector
+{
+    SimCoord x = 0;
+    SimCoord y = 0;
+};
+
+inline bool operator==(SimVector a, SimVector b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+inline bool operator!=(SimVector a, SimVector b)
+{
+    return !(a == b);
+}
+
+// A point moving along one axis for one tick, the only kind of move the snake makes.
+// Collision tests walk it to find the first distance where something is touched.
+struct SimSweep
+{
+    SimVector start;
+    int axis = 0;      // 0 = x, 1 = y
+    SimCoord sign = 1; // +1 or -1 along the axis
+    SimCoord length = 0;
+
+    SimVector at(SimCoord distance) const
+    {
+        SimVector position = start;
+        (axis == 0 ? position.x : position.y) += sign * distance;
+        return position;
+    }
+};
+
+// A move along both axes has no single sweep, and picking one axis would skip the other
+inline SimSweep makeSweep(SimVector from, SimVector to)
+{
+    assert(from.x == to.x || from.y == to.y);
+
+    SimSweep sweep;
+    sweep.start = from;
+    sweep.axis = from.x != to.x ? 0 : 1;
+    SimCoord delta = sweep.axis == 0 ? to.x - from.x : to.y - from.y;
+    sweep.sign = delta < 0 ? -1 : 1;
+    sweep.length = delta < 0 ? -delta : delta;
+    return sweep;
+}
+
+// Compile-time pixel constants (sizes, speeds) in sim units
+constexpr SimCoord toSim(float pixels)
+{
+    return static_cast<SimCoord>(pixels * SIM_ONE);
+}
+
+// Render side only. Exact, the whole world fits in a float mantissa.
+inline sf::Vector2f toPixels(SimVector position)
+{
+    return {static_cast<float>(position.x) / SIM_ONE, static_cast<float>(position.y) / SIM_ONE};
+}
@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "framearena.hpp"
+
+FrameArena::FrameArena(std::size_t capacity)
+    : buffer(new std::byte[capacity]), capacity(capacity)
+{
+}
+
+void FrameArena::reset()
+{
+    highWater = std::max(highWater, used);
+    used = 0;
+}
+
+void *FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer.get());
+    std::uintptr_t start = (base + used + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    std::size_t end = static_cast<std::size_t>(start - base) + bytes;
+    if (end > capacity)
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+
+    used = end;
+    return reinterpret_cast<void *>(start);
+}
+
+void FrameArena::do_deallocate(void *memory, std::size_t bytes, std::size_t alignment)
+{
+    // Arena memory comes back all at once in reset()
+    std::byte *pointer = static_cast<std::byte *>(memory);
+    if (pointer >= buffer.get() && pointer < buffer.get() + capacity)
+        return;
+
+    std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+#define FRAME_ARENA_BYTES (64 * 1024)
+
+// Scratch memory for objects that only live during one frame. Allocating is a pointer bump
+// and reset() hands everything back at once. Requests that don't fit go to the heap, where
+// the allocation counters will point them out.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena(std::size_t capacity = FRAME_ARENA_BYTES);
+
+    void reset();
+    std::size_t getUsed() const { return used; }
+    std::size_t getHighWater() const { return highWater; }
+    std::size_t getCapacity() const { return capacity; }
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *memory, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t capacity;
+    std::size_t used = 0;
+    std::size_t highWater = 0;
+};
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "framepacer.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace
+{
+    const char *modeNames[] = {"sleep + spin", "display vsync", "sleep", "SFML limit"};
+    static_assert(sizeof(modeNames) / sizeof(modeNames[0]) == static_cast<size_t>(PaceMode::Count));
+
+    float toMs(std::int64_t microseconds)
+    {
+        return microseconds / 1000.0f;
+    }
+
+    // Value below which the given fraction of the sorted samples lie
+    std::int64_t percentile(const std::vector<std::int64_t> &sorted, size_t count, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * count);
+        return sorted[index < count ? index : count - 1];
+    }
+}
+
+const char *paceModeName(PaceMode mode)
+{
+    return modeNames[static_cast<size_t>(mode)];
+}
+
+FramePacer::FramePacer(double framesPerSecond)
+    : frameInterval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond))),
+      oversleep(std::chrono::microseconds(PACER_MIN_SPIN_US * 2)),
+      intervals(PACER_HISTORY, 0),
+      sorted(PACER_HISTORY, 0)
+{
+    vblankSamples.reserve(PACER_VBLANK_SAMPLES);
+
+#ifdef _WIN32
+    // The default 15.6 ms scheduler tick would leave nearly the whole frame to the spin
+    timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::setMode(PaceMode newMode)
+{
+    mode = newMode;
+    presented = false;
+    vblankSamples.clear();
+    refreshPeriod = Clock::duration::zero();
+    vblanksPerFrame = 1;
+    rejectedHz = 0.0f;
+    displayFallback = false;
+    nextInterval = 0;
+    intervalCount = 0;
+    spinTotal = Clock::duration::zero();
+    framesPaced = 0;
+}
+
+FramePacer::Clock::duration FramePacer::targetInterval() const
+{
+    if (mode == PaceMode::Display && refreshPeriod > Clock::duration::zero())
+        return refreshPeriod * vblanksPerFrame;
+    return frameInterval;
+}
+
+void FramePacer::sleepUntil(Clock::time_point until)
+{
+    Clock::duration margin = Clock::duration::zero();
+    if (mode != PaceMode::Sleep)
+        margin = std::clamp<Clock::duration>(oversleep, std::chrono::microseconds(PACER_MIN_SPIN_US), std::chrono::microseconds(PACER_MAX_SPIN_US));
+
+    Clock::time_point wake = until - margin;
+    if (Clock::now() < wake)
+    {
+        std::this_thread::sleep_until(wake);
+
+        // Remember how late sleep tends to be, forgetting a bad wake-up over a second or so
+        Clock::duration late = Clock::now() - wake;
+        Clock::duration decayed = oversleep - oversleep / 64;
+        oversleep = late > decayed ? late : decayed;
+    }
+
+    if (mode == PaceMode::Sleep)
+        return;
+
+    Clock::time_point spinStart = Clock::now();
+    while (Clock::now() < until)
+        std::this_thread::yield();
+    spinTotal += Clock::now() - spinStart;
+}
+
+void FramePacer::waitForFrame()
+{
+    // Nothing to measure from yet, or SFML does the waiting
+    if (!presented || mode == PaceMode::Sfml)
+        return;
+
+    if (mode == PaceMode::Display)
+    {
+        // Vsync alone paces while the refresh is measured, and when every vblank gets a frame
+        if (refreshPeriod == Clock::duration::zero() || vblanksPerFrame == 1)
+            return;
+
+        // Present halfway through the refresh before the wanted vblank, display() blocks the rest
+        sleepUntil(lastPresent + refreshPeriod * (vblanksPerFrame - 1) + refreshPeriod / 2);
+        return;
+    }
+
+    // Deadlines follow on from each other, so the time display() takes doesn't add to the interval.
+    // A late frame starts the chain over instead of the next ones being rushed to catch up.
+    deadline += frameInterval;
+    Clock::time_point now = Clock::now();
+    if (deadline < now)
+        deadline = now;
+    sleepUntil(deadline);
+}
+
+void FramePacer::framePresented()
+{
+    Clock::time_point now = Clock::now();
+    if (presented)
+    {
+        std::int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(now - lastPresent).count();
+        intervals[nextInterval] = microseconds;
+        nextInterval = (nextInterval + 1) % PACER_HISTORY;
+        intervalCount = intervalCount < PACER_HISTORY ? intervalCount + 1 : PACER_HISTORY;
+
+        // With vsync on display() returns at a vblank, the median interval is the refresh period
+        if (mode == PaceMode::Display && refreshPeriod == Clock::duration::zero())
+        {
+            vblankSamples.push_back(microseconds);
+            if (vblankSamples.size() == PACER_VBLANK_SAMPLES)
+            {
+                std::nth_element(vblankSamples.begin(), vblankSamples.begin() + PACER_VBLANK_SAMPLES / 2, vblankSamples.end());
+                refreshPeriod = std::chrono::microseconds(vblankSamples[PACER_VBLANK_SAMPLES / 2]);
+                if (refreshPeriod > Clock::duration::zero())
+                {
+                    double ratio = std::chrono::duration<double>(frameInterval) / std::chrono::duration<double>(refreshPeriod);
+                    vblanksPerFrame = static_cast<int>(std::lround(ratio));
+                    vblanksPerFrame = vblanksPerFrame > 1 ? vblanksPerFrame : 1;
+                }
+
+                // Every frame is a tick, any other interval would change the speed of the game
+                double error = std::abs(std::chrono::duration<double>(refreshPeriod * vblanksPerFrame - frameInterval) /
+                                        std::chrono::duration<double>(frameInterval));
+                if (refreshPeriod <= Clock::duration::zero() || error > PACER_DISPLAY_TOLERANCE)
+                {
+                    float hz = refreshPeriod > Clock::duration::zero() ? 1.0f / std::chrono::duration<float>(refreshPeriod).count() : 0.0f;
+                    setMode(PaceMode::SleepSpin);
+                    rejectedHz = hz;
+                    displayFallback = true;
+                    deadline = now;
+                }
+            }
+        }
+    }
+    else
+    {
+        deadline = now;
+    }
+
+    lastPresent = now;
+    presented = true;
+    framesPaced++;
+}
+
+bool FramePacer::takeDisplayFallback()
+{
+    bool fellBack = displayFallback;
+    displayFallback = false;
+    return fellBack;
+}
+
+PacerStats FramePacer::getStats() const
+{
+    PacerStats stats;
+    stats.mode = mode;
+    stats.samples = static_cast<std::uint32_t>(intervalCount);
+    stats.rejectedHz = rejectedHz;
+    stats.targetMs = std::chrono::duration<float, std::milli>(targetInterval()).count();
+    if (refreshPeriod > Clock::duration::zero())
+        stats.displayHz = 1.0f / std::chrono::duration<float>(refreshPeriod).count();
+    if (framesPaced > 0)
+        stats.spinMs = std::chrono::duration<float, std::milli>(spinTotal).count() / framesPaced;
+    if (intervalCount == 0)
+        return stats;
+
+    std::copy(intervals.begin(), intervals.begin() + intervalCount, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + intervalCount);
+    stats.intervalMs[0] = toMs(percentile(sorted, intervalCount, 0.50));
+    stats.intervalMs[1] = toMs(percentile(sorted, intervalCount, 0.95));
+    stats.intervalMs[2] = toMs(percentile(sorted, intervalCount, 0.99));
+    stats.intervalMs[3] = toMs(sorted[intervalCount - 1]);
+
+    const std::int64_t target = std::chrono::duration_cast<std::chrono::microseconds>(targetInterval()).count();
+    for (size_t i = 0; i < intervalCount; ++i)
+        sorted[i] = std::abs(intervals[i] - target);
+    std::sort(sorted.begin(), sorted.begin() + intervalCount);
+    stats.jitterMs[0] = toMs(percentile(sorted, intervalCount, 0.50));
+    stats.jitterMs[1] = toMs(percentile(sorted, intervalCount, 0.99));
+    stats.jitterMs[2] = toMs(sorted[intervalCount - 1]);
+    return stats;
+}
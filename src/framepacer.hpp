@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#define PACER_HISTORY 600         // Frame intervals the percentiles are taken over
+#define PACER_MIN_SPIN_US 500     // Spin at least this long before a deadline, however well sleep behaves
+#define PACER_MAX_SPIN_US 4000
+#define PACER_VBLANK_SAMPLES 120  // Presents timed to measure the display's refresh period
+#define PACER_DISPLAY_TOLERANCE 0.005 // n refreshes may be off the frame interval by this much, the sim steps once per frame
+
+// How frames are held back to the frame rate
+enum class PaceMode
+{
+    SleepSpin, // Sleep most of the interval, spin-wait the rest
+    Display,   // Vertical sync, every n-th vblank, only on displays that are a multiple of the frame rate
+    Sleep,     // Sleep only, cheapest and the least precise
+    Sfml,      // window.setFramerateLimit, as before the pacer
+    Count
+};
+
+const char *paceModeName(PaceMode mode);
+
+struct PacerStats
+{
+    PaceMode mode = PaceMode::SleepSpin;
+    std::uint32_t samples = 0;
+    float targetMs = 0.0f;
+    float intervalMs[4] = {}; // p50, p95, p99, max
+    float jitterMs[3] = {};   // p50, p99, max of the distance from the target
+    float spinMs = 0.0f;      // Average spent spinning per frame
+    float displayHz = 0.0f;   // 0 until measured
+    float rejectedHz = 0.0f;  // Display mode gave up on a display this fast and fell back to SleepSpin
+};
+
+// Keeps frames evenly spaced against a monotonic clock. waitForFrame() sleeps until a little
+// before the deadline and spins the rest; the margin follows how late sleep has woken up
+// recently. In Display mode the deadline is lined up with the vblanks seen coming out of
+// display(), so that a frame never lands one refresh early or late.
+class FramePacer
+{
+public:
+    explicit FramePacer(double framesPerSecond);
+    ~FramePacer();
+
+    FramePacer(const FramePacer &) = delete;
+    FramePacer &operator=(const FramePacer &) = delete;
+
+    // Starts the history over, the window's own vsync and limit are up to the caller
+    void setMode(PaceMode newMode);
+    PaceMode getMode() const { return mode; }
+
+    // Right before and right after presenting
+    void waitForFrame();
+    void framePresented();
+    // True once after Display mode fell back to SleepSpin, the caller turns vsync off again
+    bool takeDisplayFallback();
+
+    // Sorts a copy of the history, meant for an overlay refreshing a few times a second
+    PacerStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void sleepUntil(Clock::time_point until);
+    Clock::duration targetInterval() const;
+
+    PaceMode mode = PaceMode::SleepSpin;
+    Clock::duration frameInterval;
+    Clock::time_point lastPresent;
+    Clock::time_point deadline;
+    bool presented = false;
+
+    // Late wake-ups from sleep, the spin margin is the worst recent one
+    Clock::duration oversleep;
+
+    // Display mode: refresh period measured from the first presents, then vblanks per frame
+    std::vector<std::int64_t> vblankSamples;
+    Clock::duration refreshPeriod{0};
+    int vblanksPerFrame = 1;
+    float rejectedHz = 0.0f;
+    bool displayFallback = false;
+
+    std::vector<std::int64_t> intervals; // Ring of PACER_HISTORY, microseconds
+    size_t nextInterval = 0;
+    size_t intervalCount = 0;
+    Clock::duration spinTotal{0};
+    std::uint64_t framesPaced = 0;
+    mutable std::vector<std::int64_t> sorted; // Scratch for getStats
+};
@@ -1,30 +1,137 @@
 #include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <charconv>
+#include <memory_resource>
+#include <ctime>
+#include <cmath>
+#include <cctype>
+#include <cassert>
 
 #include "game.hpp"
 #include "player.hpp"
+#include "snapshot.hpp"
+#include "sim.hpp"
+
+namespace
+{
+    // Center a label on a point, again whenever its string changes
+    void centerLabel(sf::Text &label, sf::Vector2f center)
+    {
+        sf::FloatRect bounds = label.getLocalBounds();
+        label.setOrigin({bounds.size.x / 2.0f, bounds.size.y / 2.0f});
+        label.setPosition(center);
+    }
+
+    // Centered screen text with the black outline the menus use
+    sf::Text makeLabel(const sf::Font &font, const sf::String &string, unsigned int size, sf::Vector2f center, float outline, sf::Color fill = sf::Color::White)
+    {
+        sf::Text label(font, string, size);
+        label.setFillColor(fill);
+        label.setOutlineThickness(outline);
+        label.setOutlineColor(sf::Color::Black);
+        centerLabel(label, center);
+        return label;
+    }
+
+    void appendNumber(std::pmr::string &text, long long value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+
+    // Cold to hot: blue, green, yellow, red. Zero stays see-through.
+    void heatColor(float heat, std::uint8_t *rgba)
+    {
+        static const sf::Color stops[] = {{40, 60, 255}, {0, 220, 120}, {255, 230, 0}, {255, 30, 0}};
+        if (heat <= 0.0f)
+        {
+            rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0;
+            return;
+        }
+
+        const float position = std::min(heat, 1.0f) * 3.0f;
+        const int low = std::min(static_cast<int>(position), 2);
+        const float blend = position - low;
+        const sf::Color &from = stops[low];
+        const sf::Color &to = stops[low + 1];
+        rgba[0] = static_cast<std::uint8_t>(from.r + (to.r - from.r) * blend);
+        rgba[1] = static_cast<std::uint8_t>(from.g + (to.g - from.g) * blend);
+        rgba[2] = static_cast<std::uint8_t>(from.b + (to.b - from.b) * blend);
+        rgba[3] = static_cast<std::uint8_t>(60 + (HEATMAP_OPACITY - 60) * std::min(heat, 1.0f));
+    }
+
+    // Milliseconds with one decimal
+    void appendMs(std::pmr::string &text, sf::Time time)
+    {
+        long long tenths = time.asMicroseconds() / 100;
+        appendNumber(text, tenths / 10);
+        text += '.';
+        appendNumber(text, tenths % 10);
+    }
+
+    void appendMs(std::pmr::string &text, float ms)
+    {
+        appendMs(text, sf::microseconds(static_cast<std::int64_t>(ms * 1000.0f)));
+    }
+}
 
 sf::Font g_font(FONT);
 
-Game::Game()
-    : window(sf::RenderWindow(sf::VideoMode({RESOLUTION_WIDTH, RESOLUTION_HEIGHT}), "Snake", sf::State::Fullscreen)), // Add/remove "sf::State::Fullscreen" for fullscren mode
+Game::Game(bool offscreenMode)
+    : offscreenMode(offscreenMode),
       currentState(GameState::MENU),
       nextState(GameState::MENU),
       stateChanged(false),
       direction(moveDirection::Right),
     font(FONT),
-    menuBackgroundTexture("textures/mountain/fullmountain.png"),
-    menuBackgroundSprite(menuBackgroundTexture),
+    menuBackground({RESOLUTION_WIDTH, RESOLUTION_HEIGHT}),
     gameBackgroundTexture("textures/greenpixels.jpg"),
-    gameBackgroundSprite(gameBackgroundTexture),
+    camera({RESOLUTION_WIDTH, RESOLUTION_HEIGHT}, {WORLD_WIDTH, WORLD_HEIGHT}),
+    gameBackground(gameBackgroundTexture),
       gameOverText(font, "Game Over!", 80),
       scoreText(font),
-      instructionText(font, "Press   R   to   Restart   or   M   for   Menu", 40)
+      instructionText(font, "Press   R   to   Restart   or   M   for   Menu", 40),
+      highScoreText(font, "", 35),
+      usernameText(font, "_", 60),
+      newHighScoreText(makeLabel(font, "NEW HIGH SCORE!", 50, {RESOLUTION_WIDTH / 2.0f, 420}, 2, sf::Color::Yellow)),
+      arena(ARENA_WIDTH, ARENA_HEIGHT, jobs),
+      arenaStatsText(font, "", 40),
+      statsFont(STATS_FONT),
+      statsText(statsFont, "", 20),
+      gridBoard(GRID_COLUMNS, GRID_ROWS),
+      gridStatusText(font, "", 40),
+      autopilot({WORLD_WIDTH, WORLD_HEIGHT}),
+      map(MAP_COLUMNS, MAP_ROWS),
+      wallSprite(wallTexture),
+      particles(jobs),
+      heatmapRun(HEATMAP_COLUMNS, HEATMAP_ROWS),
+      heatmapSprite(heatmapTexture),
+      heatmapText(statsFont, "", 20),
+      ghostModeText(font, "", 30),
+      rewind(MAX_SNAKE_SEGMENTS),
+      practiceModeText(font, "", 30),
+      pacer(MAX_FPS)
 {
-    sf::Image icon;
-    if (icon.loadFromFile("textures/snake.png"))
-        window.setIcon(icon);
+    // Benchmarks draw into a texture and never open a window
+    if (offscreenMode)
+    {
+        if (!offscreen.resize({RESOLUTION_WIDTH, RESOLUTION_HEIGHT}))
+            std::cerr << "Could not create the offscreen render target" << std::endl;
+        target = &offscreen;
+    }
+    else
+    {
+        window.create(sf::VideoMode({RESOLUTION_WIDTH, RESOLUTION_HEIGHT}), "Snake", sf::State::Fullscreen); // Add/remove "sf::State::Fullscreen" for fullscren mode
+
+        sf::Image icon;
+        if (icon.loadFromFile("textures/snake.png"))
+            window.setIcon(icon);
 
-    window.setFramerateLimit(MAX_FPS);
+        applyPaceMode(PaceMode::SleepSpin);
+    }
 
     // Initialize UI elements
     startButton = new Button({400.0f, 100.0f}, "Start");
@@ -53,17 +160,34 @@ Game::Game()
     resumeButton->updateText();
 
     // Position text elements
-    gameOverText.setPosition({RESOLUTION_WIDTH / 2 - 200, 200});
-    instructionText.setPosition({RESOLUTION_WIDTH / 2 - 400, 700});
+    gameOverText.setOutlineThickness(2);
+    gameOverText.setOutlineColor(sf::Color::Black);
+    centerLabel(gameOverText, {RESOLUTION_WIDTH / 2.0f, 200});
+    scoreText.setCharacterSize(60);
+    scoreText.setOutlineThickness(2);
+    scoreText.setOutlineColor(sf::Color::Black);
     instructionText.setOutlineThickness(2);
     instructionText.setOutlineColor(sf::Color::Black);
-
-    // Set up background sprites
-    sf::Vector2u menuTextureSize = menuBackgroundTexture.getSize();
-    menuBackgroundSprite.setScale({static_cast<float>(RESOLUTION_WIDTH) / menuTextureSize.x, static_cast<float>(RESOLUTION_HEIGHT) / menuTextureSize.y});
-
-    sf::Vector2u gameTextureSize = gameBackgroundTexture.getSize();
-    gameBackgroundSprite.setScale({static_cast<float>(RESOLUTION_WIDTH) / gameTextureSize.x, static_cast<float>(RESOLUTION_HEIGHT) / gameTextureSize.y});
+    centerLabel(instructionText, {RESOLUTION_WIDTH / 2.0f, 750});
+    highScoreText.setFillColor(sf::Color::Yellow);
+    highScoreText.setOutlineThickness(2);
+    highScoreText.setOutlineColor(sf::Color::Black);
+    usernameText.setPosition({(RESOLUTION_WIDTH - 600) / 2.0f + 20, 355});
+    usernameText.setFillColor(sf::Color::Black);
+    arenaStatsText.setPosition({RESOLUTION_WIDTH / 30, RESOLUTION_HEIGHT / 30});
+    arenaStatsText.setOutlineThickness(2);
+    arenaStatsText.setOutlineColor(sf::Color::Black);
+    statsText.setPosition({RESOLUTION_WIDTH / 15, RESOLUTION_HEIGHT / 15 + 70});
+    statsText.setOutlineThickness(1);
+    statsText.setOutlineColor(sf::Color::Black);
+    gridStatusText.setOutlineThickness(2);
+    gridStatusText.setOutlineColor(sf::Color::Black);
+
+    // Menu backdrop, back to front with how strongly each layer zooms and drifts
+    menuBackground.addLayer("textures/mountain/clouds.png", 0.15f);
+    menuBackground.addLayer("textures/mountain/idk.png", 0.3f);
+    menuBackground.addLayer("textures/mountain/mountain.png", 0.55f);
+    menuBackground.addLayer("textures/mountain/ground.png", 1.0f);
 
     // Initialize username and high score system
     currentUsername = "";
@@ -73,6 +197,64 @@ Game::Game()
     isNewHighScore = false;
 
     loadHighScore();
+    updateHighScoreText();
+
+    // Static screen text is laid out once instead of every frame
+    const float center = RESOLUTION_WIDTH / 2.0f;
+    menuLabels.push_back(makeLabel(font, "SNAKE  GAME", 200, {center, 150}, 4));
+    menuLabels.push_back(makeLabel(font, "Press   Enter   to   Start   or   Click   the   Button", 40, {center, 350}, 2));
+    menuLabels.push_back(makeLabel(font, "Press   G   for   Classic   Grid   or   A   to   watch   the   Arena", 30, {center, 820}, 2));
+    ghostModeText.setOutlineThickness(2);
+    ghostModeText.setOutlineColor(sf::Color::Black);
+    practiceModeText.setOutlineThickness(2);
+    practiceModeText.setOutlineColor(sf::Color::Black);
+    updateGhostModeText();
+    pauseLabels.push_back(makeLabel(font, "PAUSED", 100, {center, 300}, 2));
+    pauseLabels.push_back(makeLabel(font, "Press   Esc   or   P   to   Resume", 40, {center, 450}, 2));
+    pauseLabels.push_back(makeLabel(font, "Press   M   for   Main   Menu", 40, {center, 520}, 2));
+    pauseLabels.push_back(makeLabel(font, "Press   Q   to   Exit   Game", 40, {center, 590}, 2));
+    usernameLabels.push_back(makeLabel(font, "Enter   Username", 120, {center, 200}, 3));
+    usernameLabels.push_back(makeLabel(font, "Type   your   username   and   press   Enter   to   start", 40, {center, 500}, 2));
+    usernameLabels.push_back(makeLabel(font, "Press   Escape   to   go   back", 30, {center, 600}, 2));
+
+    // The longest snake the world can hold, so growing never reallocates mid-run
+    player.reserve(MAX_SNAKE_SEGMENTS);
+    renderSquares.reserve(2 * MAX_SNAKE_SEGMENTS + 2);
+    snakeVertices.reserve((2 * MAX_SNAKE_SEGMENTS + 2) * 6);
+    ghostVertices.reserve(GHOST_MAX_GHOSTS * (GHOST_MAX_SEGMENTS + 1) * 6);
+    foodShape.setSize({FOOD_SIZE, FOOD_SIZE});
+    foodShape.setOrigin({FOOD_SIZE / 2, FOOD_SIZE / 2});
+
+    loadMap(MAP_FILE);
+
+    // One texel per cell, smoothed when scaled up to the world
+    if (!offscreenMode)
+        heatmapStore.open(HEATMAP_FILE, HEATMAP_COLUMNS, HEATMAP_ROWS);
+    heatmapPixels.resize(static_cast<size_t>(HEATMAP_COLUMNS) * HEATMAP_ROWS * 4);
+    if (!heatmapTexture.resize({static_cast<unsigned>(HEATMAP_COLUMNS), static_cast<unsigned>(HEATMAP_ROWS)}))
+        std::cerr << "Could not create the heatmap texture" << std::endl;
+    heatmapTexture.setSmooth(true);
+    heatmapSprite.setTexture(heatmapTexture, true);
+    heatmapSprite.setScale({HEATMAP_CELL_SIZE, HEATMAP_CELL_SIZE});
+    heatmapText.setPosition({RESOLUTION_WIDTH / 15, RESOLUTION_HEIGHT / 15 + 50});
+    heatmapText.setOutlineThickness(1);
+    heatmapText.setOutlineColor(sf::Color::Black);
+
+    // Rough resident asset size for the stats segment: decoded textures plus font files
+    assetBytes += static_cast<std::uint64_t>(gameBackgroundTexture.getSize().x) * gameBackgroundTexture.getSize().y * 4;
+    assetBytes += menuBackground.getTextureBytes();
+    assetBytes += sfx.getBufferBytes();
+    std::error_code error;
+    for (const char *fontFile : {FONT, STATS_FONT})
+    {
+        auto fileSize = std::filesystem::file_size(fontFile, error);
+        if (!error)
+            assetBytes += fileSize;
+    }
+
+    // Resume a run that was paused when the game last closed
+    if (!offscreenMode && restoreSnapshot())
+        changeState(GameState::PAUSED);
 }
 
 Scoreboard::Scoreboard()
@@ -95,10 +277,10 @@ Button::Button(sf::Vector2f size, std::string buttonText)
     updateText();
 }
 
-void Button::draw(sf::RenderWindow &window)
+void Button::draw(sf::RenderTarget &target)
 {
-    window.draw(*this);
-    window.draw(text);
+    target.draw(*this);
+    target.draw(text);
 }
 
 void Button::setHovered(bool hovered)
@@ -174,6 +356,12 @@ void Scoreboard::resetScore()
     text.setString("Current score   0");
 }
 
+void Scoreboard::setScore(int score)
+{
+    currentScore = score;
+    text.setString("Current score   " + std::to_string(currentScore));
+}
+
 // ==================== STATE MACHINE ====================
 
 void Game::run()
@@ -182,58 +370,133 @@ void Game::run()
     loadBackgroundMusic("soundfx/dualofthefates.mp3");
     backgroundMusic.play();
 
+    watchdog.attach();
     while (window.isOpen() && currentState != GameState::QUIT)
-    {
-        if (stateChanged)
-        {
-            GameState previousState = currentState;
-            currentState = nextState;
-            stateChanged = false;
+        runFrame();
 
-            switch (currentState)
-            {
-            case GameState::MENU:
-                if (previousState != GameState::MENU)
-                {
-                    loadBackgroundMusic("soundfx/dualofthefates.mp3");
-                    backgroundMusic.play();
-                }
-                break;
-            case GameState::PLAYING:
-                loadBackgroundMusic("soundfx/magicmamaliga.mp3");
-                backgroundMusic.play();
-                food.spawn(player);
-                break;
-            case GameState::PAUSED:
-                backgroundMusic.pause();
-                break;
-            case GameState::GAME_OVER:
-                backgroundMusic.stop();
-                checkAndUpdateHighScore();
-                break;
-            }
-        }
+    // A snapshot saved on the way out has to reach the disk
+    if (snapshotWrite.valid())
+        snapshotWrite.wait();
+
+    // Tearing down the window and audio is slow on purpose
+    watchdog.detach();
+}
+
+void Game::runFrame()
+{
+    watchdog.beat(currentState, frameCount, static_cast<std::uint32_t>(player.tailSegments.size() + 1), scoreboard.getCurrentScore());
+    AllocCounts frameStartAllocs = allocCounts();
+    frameGrew = false;
+
+    if (stateChanged)
+    {
+        PhaseMarker phase(WatchPhase::Transition);
+        GameState previousState = currentState;
+        currentState = nextState;
+        stateChanged = false;
 
-        // Handle current state
         switch (currentState)
         {
         case GameState::MENU:
-            handleMenuState();
-            break;
-        case GameState::USERNAME_INPUT:
-            handleUsernameInputState();
+            // Leaving from pause abandons the run
+            if (previousState == GameState::PAUSED)
+                endSession();
+            if (previousState != GameState::MENU && previousState != GameState::ARENA)
+            {
+                loadBackgroundMusic("soundfx/dualofthefates.mp3");
+                backgroundMusic.play();
+            }
             break;
         case GameState::PLAYING:
-            handlePlayingState();
+            loadBackgroundMusic("soundfx/magicmamaliga.mp3");
+            backgroundMusic.play();
+            // Resuming keeps the food where it was
+            if (previousState != GameState::PAUSED)
+            {
+                food.spawn(player, map);
+                heatmapRun.foodSpawned(food.getSimPosition(), player.getSimPosition());
+                if (practiceMode)
+                    rewind.start(player, food, direction, scoreboard.getCurrentScore());
+                else
+                    rewind.stop();
+            }
+            rewindHeld = false;
+            playingFrames = 0;
             break;
         case GameState::PAUSED:
-            handlePausedState();
+            backgroundMusic.pause();
+            turnQueue.clear();
+            saveSnapshot();
             break;
         case GameState::GAME_OVER:
-            handleGameOverState();
+            backgroundMusic.stop();
+            discardSnapshot();
+            checkAndUpdateHighScore();
+            endSession();
+            updateFinalScoreText();
+            break;
+        case GameState::ARENA:
+            arena.reset(arenaSnakeCount, 12345u);
+            arenaTickTime = sf::Time::Zero;
+            arenaTicksMeasured = 0;
+            arenaReportClock.restart();
+            arenaStatsText.setString("Snakes   " + std::to_string(arenaSnakeCount));
+            break;
+        case GameState::GRID:
+            if (previousState != GameState::GRID)
+            {
+                loadBackgroundMusic("soundfx/magicmamaliga.mp3");
+                backgroundMusic.play();
+            }
+            gridBoard.reset(std::random_device{}());
+            gridTurns.clear();
+            gridOver = false;
+            gridAccumulator = sf::Time::Zero;
+            gridClock.restart();
+            scoreboard.resetScore();
             break;
         }
     }
+
+    // Handle current state
+    switch (currentState)
+    {
+    case GameState::MENU:
+        handleMenuState();
+        break;
+    case GameState::USERNAME_INPUT:
+        handleUsernameInputState();
+        break;
+    case GameState::PLAYING:
+        handlePlayingState();
+        break;
+    case GameState::PAUSED:
+        handlePausedState();
+        break;
+    case GameState::GAME_OVER:
+        handleGameOverState();
+        break;
+    case GameState::ARENA:
+        handleArenaState();
+        break;
+    case GameState::GRID:
+        handleGridState();
+        break;
+    }
+
+    {
+        AllocScope scope(AllocTag::Audio);
+        sfx.update();
+    }
+    {
+        PhaseMarker phase(WatchPhase::Stats);
+        publishStats();
+    }
+
+    // Per-frame allocation accounting, the frame arena starts over every frame
+    frameAllocs = allocCounts() - frameStartAllocs;
+    frameArena.reset();
+    checkFrameAllocations();
 }
 
 void Game::changeState(GameState newState)
@@ -243,24 +506,45 @@ void Game::changeState(GameState newState)
 }
 
 void Game::resetGame()
+{
+    resetPlayfield();
+
+    // A fresh run replaces any saved one
+    discardSnapshot();
+    beginSession();
+
+    ghostRecording.clear();
+    ghostRecordingLive = true;
+    runRewound = false;
+    if (ghostRacing)
+        startGhostRace();
+    else
+        ghosts.stop();
+}
+
+void Game::resetPlayfield()
 {
     // Reset basics
     direction = moveDirection::Right;
     scoreboard.resetScore();
-    player.setPosition({RESOLUTION_WIDTH / 2, RESOLUTION_HEIGHT / 2});
+    player.setSimPosition({toSim(WORLD_WIDTH / 2), toSim(WORLD_HEIGHT / 2)});
     player.tailSegments.clear();
+    player.tailPositions.clear();
     player.cornerSegments.clear();
     player.positionHistory.clear();
     player.framesSinceTurn = 0;
-}
-
-bool Game::isGameOver()
-{
-    return player.collidedWithBorder() || player.collidedWithSelf();
+    turnQueue.clear();
+    inputLatency.reset();
+    latencyPending = false;
+    autopilot.reset();
+    particles.clear();
+    dying = false;
 }
 
 void Game::loadBackgroundMusic(const std::string &filename)
 {
+    PhaseMarker phase(WatchPhase::Music);
+
     // Stop current music
     backgroundMusic.stop();
 
@@ -274,6 +558,79 @@ void Game::loadBackgroundMusic(const std::string &filename)
     backgroundMusic.setLooping(true);
 }
 
+void Game::loadMap(const std::string &filename)
+{
+    // A missing or broken map just means no walls
+    map.loadFromFile(filename);
+
+    const SimVector start{toSim(WORLD_WIDTH / 2), toSim(WORLD_HEIGHT / 2)};
+    if (map.overlapsWall(start, toSim(PLAYER_SIZE / 2)))
+    {
+        std::cerr << "Map " << filename << " has a wall where the snake starts, ignoring it" << std::endl;
+        map.clear();
+    }
+    autopilot.setMap(map);
+
+    // Baked once into a tile sized texture, the walls then cost a single sprite draw
+    sf::Image image({static_cast<unsigned>(map.getColumns()), static_cast<unsigned>(map.getRows())}, sf::Color::Transparent);
+    for (int y = 0; y < map.getRows(); ++y)
+        for (int x = 0; x < map.getColumns(); ++x)
+            if (map.isWall(x, y))
+                image.setPixel({static_cast<unsigned>(x), static_cast<unsigned>(y)}, WALL_COLOR);
+
+    if (!wallTexture.loadFromImage(image))
+        std::cerr << "Could not create the wall texture" << std::endl;
+    wallTexture.setSmooth(false);
+    wallSprite.setTexture(wallTexture, true);
+    wallSprite.setScale({MAP_TILE_SIZE, MAP_TILE_SIZE});
+    assetBytes += static_cast<std::uint64_t>(map.getColumns()) * map.getRows() * 4;
+}
+
+void Game::publishStats()
+{
+    float frameMs = frameClock.restart().asMicroseconds() / 1000.0f;
+    frameCount++;
+    frameTimeAverageMs = frameCount == 1 ? frameMs : frameTimeAverageMs + (frameMs - frameTimeAverageMs) * 0.05f;
+    frameTimeWindowMaxMs = std::max(frameTimeWindowMaxMs, frameMs);
+
+    // Tick rate and worst frame are taken over one second windows
+    float windowSeconds = statsWindowClock.getElapsedTime().asSeconds();
+    if (windowSeconds >= 1.0f)
+    {
+        ticksPerSecond = (tickCount - ticksAtWindowStart) / windowSeconds;
+        ticksAtWindowStart = tickCount;
+        frameTimeMaxMs = frameTimeWindowMaxMs;
+        frameTimeWindowMaxMs = 0.0f;
+        statsWindowClock.restart();
+    }
+
+    if (currentState == GameState::PLAYING && sessionActive)
+    {
+        session.frames.add(frameMs);
+        sessionPlayMs += frameMs;
+    }
+
+    if (!statsPublisher.isOpen())
+        return;
+
+    StatsCounters counters{};
+    counters.frameCount = frameCount;
+    counters.tickCount = tickCount;
+    counters.frameTimeMs = frameMs;
+    counters.frameTimeAverageMs = frameTimeAverageMs;
+    counters.frameTimeMaxMs = frameTimeMaxMs;
+    counters.ticksPerSecond = ticksPerSecond;
+    counters.inputLatencyMs = inputLatency.getLast().asMicroseconds() / 1000.0f;
+    counters.inputLatencyAverageMs = inputLatency.getAverage().asMicroseconds() / 1000.0f;
+    counters.snakeLength = static_cast<std::uint32_t>(player.tailSegments.size() + 1);
+    counters.score = scoreboard.getCurrentScore();
+    counters.gameState = static_cast<std::uint32_t>(currentState);
+    counters.assetBytes = assetBytes;
+    counters.sfxActiveVoices = sfx.getStats().activeVoices;
+    counters.sfxSteals = static_cast<std::uint32_t>(sfx.getStats().steals);
+    statsPublisher.publish(counters);
+}
+
 // ========== STATE HANDLERS ==========
 
 void Game::handleMenuState()
@@ -299,22 +656,64 @@ void Game::handleMenuState()
             zoomingIn = true;
         }
     }
+    backgroundSeconds += 1.0f / MAX_FPS;
 
     drawMenu();
 }
 
 void Game::handlePlayingState()
 {
-    // Load soundFX
-    sf::SoundBuffer popBuffer("soundfx/pop.mp3");
-    sf::Sound pop(popBuffer);
-    pop.setVolume(50);
+    // Charged to input unless a narrower scope below says otherwise
+    AllocScope inputScope(AllocTag::Input);
+
+    // The snake is breaking apart, only the effect runs until the game over screen
+    if (dying)
+    {
+        while (const std::optional event = window.pollEvent())
+        {
+            if (event->is<sf::Event::Closed>())
+            {
+                // The run is over, it can't be resumed
+                discardSnapshot();
+                changeState(GameState::QUIT);
+                return;
+            }
+
+            // Practice takes the death back and starts rewinding right away
+            auto *keyPressed = event->getIf<sf::Event::KeyPressed>();
+            if (keyPressed && keyPressed->code == sf::Keyboard::Key::Backspace && rewind.isStarted())
+            {
+                dying = false;
+                particles.clear();
+                session.deathCause = static_cast<std::uint8_t>(DeathCause::None);
+                rewindHeld = true;
+                rewindStep();
+                return;
+            }
+        }
+
+        {
+            AllocScope scope(AllocTag::Render);
+            particles.update(PARTICLE_STEP);
+        }
+        drawGame();
+
+        if (dyingClock.getElapsedTime() >= sf::milliseconds(DEATH_ANIMATION_MS))
+        {
+            dying = false;
+            changeState(GameState::GAME_OVER);
+        }
+        return;
+    }
 
     // Handle input including movement
+    PhaseMarker eventsPhase(WatchPhase::Events);
     while (const std::optional event = window.pollEvent())
     {
         if (event->is<sf::Event::Closed>())
         {
+            // Closing mid-run keeps it resumable, pausing already saved on the way in
+            saveSnapshot();
             changeState(GameState::QUIT);
             return;
         }
@@ -327,80 +726,185 @@ void Game::handlePlayingState()
                 return;
             }
 
-            // Movement controls
-            const int minFramesBetweenTurns = 2 * framesPerSegment;
+            // Movement controls are queued with the time they were read, steering takes over from the autopilot
+            sf::Time now = inputClock.getElapsedTime();
             switch (keyPressed->code)
             {
             case sf::Keyboard::Key::Up:
-                if (direction != moveDirection::Down && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Up;
+                autopilotEnabled = false;
+                turnQueue.push(moveDirection::Up, direction, now);
                 break;
             case sf::Keyboard::Key::Down:
-                if (direction != moveDirection::Up && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Down;
+                autopilotEnabled = false;
+                turnQueue.push(moveDirection::Down, direction, now);
                 break;
             case sf::Keyboard::Key::Left:
-                if (direction != moveDirection::Right && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Left;
+                autopilotEnabled = false;
+                turnQueue.push(moveDirection::Left, direction, now);
                 break;
             case sf::Keyboard::Key::Right:
-                if (direction != moveDirection::Left && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Right;
+                autopilotEnabled = false;
+                turnQueue.push(moveDirection::Right, direction, now);
+                break;
+            case sf::Keyboard::Key::T:
+                autopilotEnabled = !autopilotEnabled;
+                session.autopilot = session.autopilot || autopilotEnabled;
+                autopilot.reset();
+                turnQueue.clear();
+                break;
+            case sf::Keyboard::Key::F3:
+                showStats = !showStats;
+                break;
+            case sf::Keyboard::Key::F4:
+                applyPaceMode(static_cast<PaceMode>((static_cast<int>(paceMode) + 1) % static_cast<int>(PaceMode::Count)));
+                break;
+            case sf::Keyboard::Key::H:
+                // Off, then each layer in turn
+                heatmapShown = heatmapShown + 1 < static_cast<int>(HEAT_LAYER_COUNT) ? heatmapShown + 1 : -1;
+                if (heatmapShown >= 0)
+                    refreshHeatmap();
+                break;
+            case sf::Keyboard::Key::Backspace:
+                rewindHeld = rewind.isStarted();
                 break;
             }
         }
+
+        if (auto *keyReleased = event->getIf<sf::Event::KeyReleased>())
+        {
+            if (keyReleased->code == sf::Keyboard::Key::Backspace)
+                rewindHeld = false;
+        }
     }
 
-    if (isGameOver())
+    // Held rewind replaces this frame's tick with a step back
+    if (rewindHeld)
     {
-        changeState(GameState::GAME_OVER);
+        rewindStep();
         return;
     }
 
-    if (player.eat(food))
+    PhaseMarker simulationPhase(WatchPhase::Simulation);
+    TickResult tick;
+    {
+        AllocScope scope(AllocTag::Sim);
+        tick = checkTick(player, food, map);
+    }
+
+    // Food reached just before a fatal step still scores
+    if (tick.ate)
     {
-        pop.play();
-        player.spawnTail();
-        food.spawn(player);
+        frameGrew = true;
+        {
+            AllocScope scope(AllocTag::Audio);
+            sfx.play(SoundId::Eat);
+        }
+        AllocScope scope(AllocTag::Render);
         scoreboard.increaseScore(10);
+        particles.burst(player.getPosition(), food.getFillColor(), PARTICLE_EAT_COUNT, 300.0f, 0.6f);
+        heatmapRun.foodEaten();
+        heatmapRun.foodSpawned(food.getSimPosition(), player.getSimPosition());
     }
 
-    // Update player movement
-    switch (direction)
+    if (tick.death != DeathCause::None)
     {
-    case moveDirection::Up:
-        player.moveSnake(moveDirection::Up);
-        break;
-    case moveDirection::Down:
-        player.moveSnake(moveDirection::Down);
-        break;
-    case moveDirection::Left:
-        player.moveSnake(moveDirection::Left);
-        break;
-    case moveDirection::Right:
-        player.moveSnake(moveDirection::Right);
-        break;
+        session.deathCause = static_cast<std::uint8_t>(tick.death);
+        heatmapRun.death(player.getSimPosition());
+        dying = true;
+        dyingClock.restart();
+        {
+            AllocScope scope(AllocTag::Audio);
+            sfx.play(SoundId::Death);
+        }
+        {
+            AllocScope scope(AllocTag::Render);
+            particles.disintegrate(player);
+        }
+        drawGame();
+        return;
     }
 
-    player.incrementFramesSinceTurn();
-    player.storePosition();
-    player.updateTail();
-    player.updateCorners();
+    {
+        AllocScope scope(AllocTag::Sim);
+        heatmapRun.tick(player.getSimPosition());
+        if (ghostRecordingLive && ghostRecording.record(player.getSimPosition(), static_cast<std::uint32_t>(player.tailSegments.size() + 1)))
+            frameGrew = true;
+        ghosts.tick();
+    }
 
-    // Draw everything
-    window.clear();
-    window.draw(gameBackgroundSprite);
-    window.draw(player);
+    // The autopilot drives through the same turn queue as the keyboard
+    if (autopilotEnabled)
+    {
+        AllocScope scope(AllocTag::Autopilot);
+        PhaseMarker phase(WatchPhase::Autopilot);
+        moveDirection planned;
+        if (autopilot.decide(player, food, direction, planned))
+            turnQueue.push(planned, direction, inputClock.getElapsedTime());
+    }
 
-    for (const auto &segment : player.tailSegments)
-        window.draw(segment);
+    // Apply the oldest buffered turn as soon as the snake is allowed to turn
+    PendingTurn turn;
+    if (turnQueue.popReady(direction, player.framesSinceTurn, 2 * framesPerSegment, turn))
+    {
+        direction = turn.direction;
+        latencyStamp = turn.timestamp;
+        latencyPending = true;
+        latencyTick = tickCount + 1; // The tick about to be simulated is the first to show it
+        session.turns++;
+
+        AllocScope scope(AllocTag::Audio);
+        sfx.play(SoundId::Turn);
+    }
 
-    for (const auto &corner : player.cornerSegments)
-        window.draw(corner.shape);
+    // Pipeline: this tick is captured for drawing, then the next one is simulated on a worker
+    // while the capture is turned into vertices and submitted. The frame shows the tick before
+    // the one being simulated, one tick of latency for taking the sim off the main thread.
+    capturePlayfield();
+    jobs.launch(tickJob, [](void *game)
+                { static_cast<Game *>(game)->simulateTick(); }, this);
+    tickCount++;
+    playingFrames++;
+    session.ticks++;
 
-    window.draw(food);
-    window.draw(scoreboard.text);
-    window.display();
+    {
+        AllocScope scope(AllocTag::Render);
+        particles.update(PARTICLE_STEP);
+    }
+    drawPlayfield();
+
+    // Everything outside this function may look at the snake again
+    jobs.wait(tickJob);
+    rewind.record(player, food, direction, scoreboard.getCurrentScore(), tick.ate);
+}
+
+void Game::rewindStep()
+{
+    // One tick back per frame, the pace it was played at
+    PhaseMarker phase(WatchPhase::Simulation);
+    int score = scoreboard.getCurrentScore();
+    if (rewind.stepBack(player, food, map, direction, score))
+    {
+        scoreboard.setScore(score);
+        runRewound = true;
+    }
+
+    // Nothing queued or planned for the state that was just left
+    turnQueue.clear();
+    latencyPending = false;
+    autopilot.reset();
+
+    {
+        AllocScope scope(AllocTag::Render);
+        particles.update(PARTICLE_STEP);
+    }
+    drawGame();
+}
+
+void Game::simulateTick()
+{
+    // Runs on a worker, the main thread leaves the player alone until it's waited on
+    AllocScope scope(AllocTag::Sim);
+    advanceTick(player, direction, &jobs);
 }
 
 void Game::handlePausedState()
@@ -415,6 +919,33 @@ void Game::handleGameOverState()
     drawGameOver();
 }
 
+void Game::handleArenaState()
+{
+    handleArenaInput();
+    if (currentState != GameState::ARENA || stateChanged)
+        return;
+
+    // Only the simulation is timed, so the figure is the engine's throughput rather than the frame rate
+    sf::Clock tickClock;
+    arena.tick();
+    arenaTickTime += tickClock.getElapsedTime();
+    tickCount++;
+    arenaTicksMeasured++;
+
+    if (arenaReportClock.getElapsedTime() >= sf::seconds(0.5f) && arenaTicksMeasured > 0)
+    {
+        int ticksPerSecond = static_cast<int>(arenaTicksMeasured / arenaTickTime.asSeconds());
+        arenaStatsText.setString("Snakes   " + std::to_string(arena.getSnakeCount()) +
+                                 "   Ticks per second   " + std::to_string(ticksPerSecond) +
+                                 "   Threads   " + std::to_string(jobs.getWorkerCount() + 1));
+        arenaTickTime = sf::Time::Zero;
+        arenaTicksMeasured = 0;
+        arenaReportClock.restart();
+    }
+
+    drawArena();
+}
+
 // ========== INPUT HANDLERS ==========
 
 void Game::handleMenuInput()
@@ -437,6 +968,26 @@ void Game::handleMenuInput()
                 changeState(GameState::USERNAME_INPUT);
                 return;
             }
+            if (keyPressed->code == sf::Keyboard::Key::A)
+            {
+                changeState(GameState::ARENA);
+                return;
+            }
+            if (keyPressed->code == sf::Keyboard::Key::G)
+            {
+                changeState(GameState::GRID);
+                return;
+            }
+            if (keyPressed->code == sf::Keyboard::Key::R)
+            {
+                ghostRacing = !ghostRacing;
+                updateGhostModeText();
+            }
+            if (keyPressed->code == sf::Keyboard::Key::P)
+            {
+                practiceMode = !practiceMode;
+                updateGhostModeText();
+            }
         }
 
         // Handle mouse button press
@@ -490,7 +1041,49 @@ void Game::handleMenuInput()
     }
 }
 
-void Game::handleGameInput()
+void Game::handleGridState()
+{
+    handleGridInput();
+    if (currentState != GameState::GRID || stateChanged)
+        return;
+
+    // Fixed rate ticks, decoupled from the frame rate so tournaments can run far above it
+    gridAccumulator += gridClock.restart();
+    const sf::Time tickTime = sf::seconds(1.0f / gridTicksPerSecond);
+    int ticksThisFrame = 0;
+    while (!gridOver && gridAccumulator >= tickTime && ticksThisFrame < 256)
+    {
+        gridAccumulator -= tickTime;
+        ticksThisFrame++;
+
+        PendingTurn turn;
+        moveDirection heading = gridBoard.getHeading();
+        if (gridTurns.popReady(heading, 1, 0, turn))
+            heading = turn.direction;
+
+        switch (gridBoard.step(heading))
+        {
+        case GridStep::Ate:
+            scoreboard.increaseScore(10);
+            break;
+        case GridStep::Died:
+        case GridStep::Won:
+            gridOver = true;
+            break;
+        default:
+            break;
+        }
+        tickCount++;
+    }
+
+    // Don't bank time while dead or when the frame budget was exceeded
+    if (gridOver || ticksThisFrame == 256)
+        gridAccumulator = sf::Time::Zero;
+
+    drawGrid();
+}
+
+void Game::handleGridInput()
 {
     while (const std::optional event = window.pollEvent())
     {
@@ -502,48 +1095,75 @@ void Game::handleGameInput()
 
         if (auto *keyPressed = event->getIf<sf::Event::KeyPressed>())
         {
-            const int minFramesBetweenTurns = 2 * framesPerSegment;
-
+            sf::Time now = inputClock.getElapsedTime();
             switch (keyPressed->code)
             {
             case sf::Keyboard::Key::Up:
-                if (direction != moveDirection::Down && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Up;
+                gridTurns.push(moveDirection::Up, gridBoard.getHeading(), now);
                 break;
             case sf::Keyboard::Key::Down:
-                if (direction != moveDirection::Up && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Down;
+                gridTurns.push(moveDirection::Down, gridBoard.getHeading(), now);
                 break;
             case sf::Keyboard::Key::Left:
-                if (direction != moveDirection::Right && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Left;
+                gridTurns.push(moveDirection::Left, gridBoard.getHeading(), now);
                 break;
             case sf::Keyboard::Key::Right:
-                if (direction != moveDirection::Left && player.framesSinceTurn >= minFramesBetweenTurns)
-                    direction = moveDirection::Right;
+                gridTurns.push(moveDirection::Right, gridBoard.getHeading(), now);
+                break;
+            case sf::Keyboard::Key::PageUp:
+                gridTicksPerSecond = std::min(gridTicksPerSecond * 2, GRID_MAX_TICKS_PER_SECOND);
+                break;
+            case sf::Keyboard::Key::PageDown:
+                gridTicksPerSecond = std::max(gridTicksPerSecond / 2, 1);
                 break;
+            case sf::Keyboard::Key::R:
+                if (gridOver)
+                    changeState(GameState::GRID);
+                return;
             case sf::Keyboard::Key::Escape:
-                changeState(GameState::PAUSED);
+            case sf::Keyboard::Key::M:
+                changeState(GameState::MENU);
                 return;
             }
         }
     }
+}
 
-    // Update player movement
-    switch (direction)
+void Game::handleArenaInput()
+{
+    while (const std::optional event = window.pollEvent())
     {
-    case moveDirection::Up:
-        player.moveSnake(moveDirection::Up);
-        break;
-    case moveDirection::Down:
-        player.moveSnake(moveDirection::Down);
-        break;
-    case moveDirection::Left:
-        player.moveSnake(moveDirection::Left);
-        break;
-    case moveDirection::Right:
-        player.moveSnake(moveDirection::Right);
-        break;
+        if (event->is<sf::Event::Closed>())
+        {
+            changeState(GameState::QUIT);
+            return;
+        }
+
+        if (auto *keyPressed = event->getIf<sf::Event::KeyPressed>())
+        {
+            switch (keyPressed->code)
+            {
+            case sf::Keyboard::Key::Escape:
+            case sf::Keyboard::Key::M:
+                changeState(GameState::MENU);
+                return;
+            case sf::Keyboard::Key::Up:
+                // Double or halve the population and restart the measurement
+                if (arenaSnakeCount < ARENA_MAX_SNAKES)
+                {
+                    arenaSnakeCount *= 2;
+                    changeState(GameState::ARENA);
+                }
+                return;
+            case sf::Keyboard::Key::Down:
+                if (arenaSnakeCount > ARENA_MIN_SNAKES)
+                {
+                    arenaSnakeCount /= 2;
+                    changeState(GameState::ARENA);
+                }
+                return;
+            }
+        }
     }
 }
 
@@ -658,172 +1278,467 @@ void Game::handleGameOverInput()
 
 // ========== DRAWING METHODS ==========
 
-void Game::drawMenu()
+void Game::present()
 {
-    window.clear();
-
-    // Apply zoom effect to background
-    menuBackgroundSprite.setScale({backgroundZoom, backgroundZoom});
-
-    // Center the scaled background
-    sf::FloatRect bgBounds = menuBackgroundSprite.getGlobalBounds();
-    menuBackgroundSprite.setPosition({(RESOLUTION_WIDTH - bgBounds.size.x) / 2.0f,
-                                      (RESOLUTION_HEIGHT - bgBounds.size.y) / 2.0f});
-
-    window.draw(menuBackgroundSprite);
-    startButton->draw(window);
-    exitButton->draw(window);
-
-    // Add title text
-    sf::Text titleText(font, "SNAKE  GAME", 200);
-    sf::FloatRect titleBounds = titleText.getLocalBounds();
-    titleText.setOrigin({titleBounds.size.x / 2.0f, titleBounds.size.y / 2.0f});
-    titleText.setPosition({RESOLUTION_WIDTH / 2.0f, 150});
-    titleText.setFillColor(sf::Color::White);
-    titleText.setOutlineThickness(4);
-    titleText.setOutlineColor(sf::Color::Black);
-    window.draw(titleText);
-
-    // Add instruction text
-    sf::Text startText(font, "Press   Enter   to   Start   or   Click   the   Button", 40);
-    sf::FloatRect startBounds = startText.getLocalBounds();
-    startText.setOrigin({startBounds.size.x / 2.0f, startBounds.size.y / 2.0f});
-    startText.setPosition({RESOLUTION_WIDTH / 2.0f, 350});
-    startText.setFillColor(sf::Color::White);
-    startText.setOutlineThickness(2);
-    startText.setOutlineColor(sf::Color::Black);
-    window.draw(startText);
-
-    // Add high score display
-    std::string highScoreStr = "High   Score   " + std::to_string(highScore) + "   by   " + highScoreUsername;
-    sf::Text highScoreText(font, highScoreStr, 35);
-    sf::FloatRect highScoreBounds = highScoreText.getLocalBounds();
-    highScoreText.setOrigin({highScoreBounds.size.x / 2.0f, highScoreBounds.size.y / 2.0f});
-    highScoreText.setPosition({RESOLUTION_WIDTH / 2.0f, 750});
-    highScoreText.setFillColor(sf::Color::Yellow);
-    highScoreText.setOutlineThickness(2);
-    highScoreText.setOutlineColor(sf::Color::Black);
-    window.draw(highScoreText);
+    // Waits on the driver, and on the frame limit
+    PhaseMarker phase(WatchPhase::Present);
+
+    if (offscreenMode)
+    {
+        offscreen.display();
+        return;
+    }
 
+    pacer.waitForFrame();
     window.display();
+    pacer.framePresented();
+
+    // The display can't hold the game at MAX_FPS, the pacer carries on without vsync
+    if (pacer.takeDisplayFallback())
+        window.setVerticalSyncEnabled(false);
 }
 
-void Game::drawGame()
+void Game::applyPaceMode(PaceMode mode)
+{
+    // Only one thing may hold the frame back, the pacer or vsync or SFML's own limit
+    window.setVerticalSyncEnabled(mode == PaceMode::Display);
+    window.setFramerateLimit(mode == PaceMode::Sfml ? MAX_FPS : 0);
+    pacer.setMode(mode);
+    paceMode = mode;
+}
+
+void Game::drawMenu()
 {
-    window.clear();
-    window.draw(gameBackgroundSprite);
+    target->clear();
+
+    drawMenuBackground();
+    startButton->draw(*target);
+    exitButton->draw(*target);
 
-    // Draw everything
-    window.draw(player);
+    for (const auto &label : menuLabels)
+        target->draw(label);
+    target->draw(highScoreText);
+    target->draw(ghostModeText);
+    target->draw(practiceModeText);
 
-    for (const auto &segment : player.tailSegments)
-        window.draw(segment);
+    present();
+}
 
+void Game::drawMenuBackground()
+{
+    // The layers were cached at load, this only moves a quad per layer
+    float drift = std::sin(backgroundSeconds * 6.2831853f / PARALLAX_SWAY_SECONDS);
+    menuBackground.draw(*target, backgroundZoom, drift);
+}
+
+void Game::drawArena()
+{
+    target->clear();
+
+    // Whole arena in one vertex array, scaled to fill the screen
+    arena.buildVertices(arenaVertices);
+    sf::Vector2f worldSize = arena.getWorldSize();
+    target->setView(sf::View(sf::FloatRect({0.0f, 0.0f}, worldSize)));
+    target->draw(arenaVertices);
+
+    target->setView(target->getDefaultView());
+    target->draw(arenaStatsText);
+
+    present();
+}
+
+void Game::drawGame()
+{
+    capturePlayfield();
+    drawPlayfield();
+}
+
+void Game::capturePlayfield()
+{
+    // Plain copies into reserved storage, cheap next to building and submitting the draws
+    renderSquares.clear();
+    renderSquares.push_back(player.getSimPosition());
+    renderSquares.insert(renderSquares.end(), player.tailPositions.begin(), player.tailPositions.end());
     for (const auto &corner : player.cornerSegments)
-        window.draw(corner.shape);
+        renderSquares.push_back(corner.position);
 
-    window.draw(food);
-    window.draw(scoreboard.text);
+    snakeColor = player.getFillColor();
+    foodShape.setPosition(food.getPosition());
+    foodShape.setFillColor(food.getFillColor());
+    renderedTicks = tickCount;
+}
 
-    window.display();
+void Game::drawPlayfield()
+{
+    AllocScope scope(AllocTag::Render);
+    PhaseMarker phase(WatchPhase::Draw);
+
+    target->clear();
+
+    // World space: only what the camera can see is submitted
+    camera.follow(toPixels(renderSquares.front()));
+    camera.apply(*target);
+    gameBackground.draw(*target, camera);
+    if (heatmapShown >= 0)
+    {
+        if (heatmapRefreshClock.getElapsedTime() >= sf::milliseconds(HEATMAP_REFRESH_MS))
+            refreshHeatmap();
+        target->draw(heatmapSprite);
+    }
+    if (map.hasWalls())
+        target->draw(wallSprite);
+
+    // Under the live snake, they only ever pass through it
+    if (ghosts.isRacing())
+    {
+        ghostVertices.clear();
+        ghosts.appendVertices(ghostVertices, camera);
+        if (!ghostVertices.empty())
+            target->draw(ghostVertices.data(), ghostVertices.size(), sf::PrimitiveType::Triangles);
+    }
+
+    // A dying snake has already turned into particles. Head, tail and corners are all the
+    // same square, so the visible ones go out as one triangle list.
+    if (!dying)
+    {
+        const float half = PLAYER_SIZE / 2;
+        snakeVertices.clear();
+        for (const SimVector &square : renderSquares)
+        {
+            const sf::Vector2f position = toPixels(square);
+            if (!camera.isVisible(position, half))
+                continue;
+
+            const sf::Vector2f topLeft{position.x - half, position.y - half};
+            const sf::Vector2f bottomRight{position.x + half, position.y + half};
+            snakeVertices.push_back({topLeft, snakeColor});
+            snakeVertices.push_back({{bottomRight.x, topLeft.y}, snakeColor});
+            snakeVertices.push_back({bottomRight, snakeColor});
+            snakeVertices.push_back({topLeft, snakeColor});
+            snakeVertices.push_back({bottomRight, snakeColor});
+            snakeVertices.push_back({{topLeft.x, bottomRight.y}, snakeColor});
+        }
+        if (!snakeVertices.empty())
+            target->draw(snakeVertices.data(), snakeVertices.size(), sf::PrimitiveType::Triangles);
+    }
+
+    if (camera.isVisible(foodShape.getPosition(), FOOD_SIZE / 2))
+        target->draw(foodShape);
+
+    particles.draw(*target);
+
+    // Screen space HUD
+    target->setView(target->getDefaultView());
+    target->draw(scoreboard.text);
+    if (heatmapShown >= 0)
+        target->draw(heatmapText);
+
+    if (showStats)
+        drawStats();
+
+    present();
+
+    // This frame is the first to show the latest turn, timed once it's on the display and not
+    // just submitted, so the pacer's wait and display() count too
+    if (latencyPending && renderedTicks >= latencyTick)
+    {
+        inputLatency.record(inputClock.getElapsedTime() - latencyStamp);
+        latencyPending = false;
+    }
+}
+
+void Game::drawGrid()
+{
+    target->clear();
+    drawMenuBackground();
+
+    // Board, body and food in one vertex array
+    const sf::Vector2f origin{(RESOLUTION_WIDTH - GRID_COLUMNS * GRID_CELL_SIZE) / 2.0f,
+                              (RESOLUTION_HEIGHT - GRID_ROWS * GRID_CELL_SIZE) / 2.0f};
+    gridVertices.setPrimitiveType(sf::PrimitiveType::Triangles);
+    gridVertices.clear();
+
+    auto addRect = [&](sf::Vector2f position, sf::Vector2f size, sf::Color color)
+    {
+        sf::Vector2f end = position + size;
+        gridVertices.append({position, color});
+        gridVertices.append({{end.x, position.y}, color});
+        gridVertices.append({end, color});
+        gridVertices.append({position, color});
+        gridVertices.append({end, color});
+        gridVertices.append({{position.x, end.y}, color});
+    };
+    auto addCell = [&](std::uint32_t cell, sf::Color color)
+    {
+        sf::Vector2f position{origin.x + (cell % GRID_COLUMNS) * GRID_CELL_SIZE + 1.0f,
+                              origin.y + (cell / GRID_COLUMNS) * GRID_CELL_SIZE + 1.0f};
+        addRect(position, {GRID_CELL_SIZE - 2.0f, GRID_CELL_SIZE - 2.0f}, color);
+    };
+
+    addRect(origin, {GRID_COLUMNS * GRID_CELL_SIZE, GRID_ROWS * GRID_CELL_SIZE}, sf::Color(0, 60, 0, 200));
+    if (gridBoard.getFoodCell() >= 0)
+        addCell(static_cast<std::uint32_t>(gridBoard.getFoodCell()), sf::Color::Red);
+    for (std::uint32_t i = 0; i < gridBoard.getLength(); ++i)
+        addCell(gridBoard.getBodyCell(i), i == 0 ? sf::Color::Yellow : sf::Color(144, 238, 144));
+    target->draw(gridVertices);
+
+    target->draw(scoreboard.text);
+
+    std::string status = "Ticks per second   " + std::to_string(gridTicksPerSecond) +
+                         "   Free cells   " + std::to_string(gridBoard.getFreeCellCount());
+    if (gridOver)
+        status += "      Press   R   to   Restart   or   M   for   Menu";
+    gridStatusText.setString(status);
+    gridStatusText.setPosition({RESOLUTION_WIDTH / 15, RESOLUTION_HEIGHT - RESOLUTION_HEIGHT / 15});
+    target->draw(gridStatusText);
+
+    present();
+}
+
+void Game::drawStats()
+{
+    AllocScope scope(AllocTag::Overlay);
+
+    // Rebuilt a few times a second, numbers changing at frame rate can't be read anyway
+    if (statsRefreshClock.getElapsedTime() >= sf::milliseconds(STATS_REFRESH_MS) || statsText.getString().isEmpty())
+    {
+        statsRefreshClock.restart();
+
+        // Built in the frame arena, only the hand-over to sf::Text touches the heap
+        std::pmr::string text(&frameArena);
+        text.reserve(512);
+        text += "Input latency (ms)  last ";
+        appendMs(text, inputLatency.getLast());
+        text += "  avg ";
+        appendMs(text, inputLatency.getAverage());
+        text += "  min ";
+        appendMs(text, inputLatency.getMin());
+        text += "  max ";
+        appendMs(text, inputLatency.getMax());
+        text += "  turns ";
+        appendNumber(text, static_cast<long long>(inputLatency.getSamples()));
+        text += "  queued ";
+        appendNumber(text, static_cast<long long>(turnQueue.size()));
+
+        text += "\nAllocations last frame ";
+        for (std::size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag)
+        {
+            text += "  ";
+            text += allocTagName(static_cast<AllocTag>(tag));
+            text += ' ';
+            appendNumber(text, static_cast<long long>(frameAllocs.allocations[tag]));
+        }
+        text += "  arena peak (KB) ";
+        appendNumber(text, static_cast<long long>(frameArena.getHighWater() / 1024));
+
+        const SfxStats &sound = sfx.getStats();
+        text += "\nSound voices  active ";
+        appendNumber(text, static_cast<long long>(sound.activeVoices));
+        text += " of ";
+        appendNumber(text, SFX_VOICE_COUNT);
+        text += "  peak ";
+        appendNumber(text, static_cast<long long>(sound.peakVoices));
+        text += "  plays ";
+        appendNumber(text, static_cast<long long>(sound.plays));
+        text += "  steals ";
+        appendNumber(text, static_cast<long long>(sound.steals));
+        text += "  drops ";
+        appendNumber(text, static_cast<long long>(sound.drops));
+        text += "  cooldown skips ";
+        appendNumber(text, static_cast<long long>(sound.cooldownSkips));
+
+        const WatchdogStats stalls = watchdog.getStats();
+        text += "\nHitches over ";
+        appendNumber(text, WATCHDOG_DEADLINE_MS);
+        text += " ms  ";
+        appendNumber(text, static_cast<long long>(stalls.hitches));
+        if (stalls.hitches > 0)
+        {
+            text += "  worst (ms) ";
+            appendNumber(text, stalls.worstMs);
+            text += "  last in ";
+            text += watchPhaseName(stalls.lastPhase);
+        }
+
+        const PacerStats pacing = pacer.getStats();
+        text += "\nFrame pacing (F4)  ";
+        text += paceModeName(pacing.mode);
+        if (pacing.displayHz > 0.0f)
+        {
+            text += " at ";
+            appendNumber(text, std::lround(pacing.displayHz));
+            text += " Hz";
+        }
+        if (pacing.rejectedHz > 0.0f)
+        {
+            text += " (display at ";
+            appendNumber(text, std::lround(pacing.rejectedHz));
+            text += " Hz isn't a multiple of ";
+            appendNumber(text, MAX_FPS);
+            text += ", vsync would change the game speed)";
+        }
+        text += "  interval (ms) p50 ";
+        appendMs(text, pacing.intervalMs[0]);
+        text += "  p95 ";
+        appendMs(text, pacing.intervalMs[1]);
+        text += "  p99 ";
+        appendMs(text, pacing.intervalMs[2]);
+        text += "  max ";
+        appendMs(text, pacing.intervalMs[3]);
+        text += "  jitter p50 ";
+        appendMs(text, pacing.jitterMs[0]);
+        text += "  p99 ";
+        appendMs(text, pacing.jitterMs[1]);
+        text += "  spin/frame ";
+        appendMs(text, pacing.spinMs);
+
+        if (rewind.isStarted())
+        {
+            const RewindStats history = rewind.getStats();
+            text += "\nRewind (Backspace)  available (ticks) ";
+            appendNumber(text, static_cast<long long>(history.availableTicks));
+            text += "  keyframes ";
+            appendNumber(text, static_cast<long long>(history.keyframes));
+            text += "  KB ";
+            appendNumber(text, static_cast<long long>(history.keyframeBytes / 1024));
+            text += "  last replay (ticks) ";
+            appendNumber(text, static_cast<long long>(history.lastReplayTicks));
+        }
+
+        if (ghosts.isRacing())
+        {
+            const GhostStats race = ghosts.getStats();
+            text += "\nGhosts ";
+            appendNumber(text, static_cast<long long>(race.ghosts));
+            text += "  decoded ahead (ticks) ";
+            appendNumber(text, static_cast<long long>(race.minAhead));
+            text += "  underruns ";
+            appendNumber(text, static_cast<long long>(race.underruns));
+            text += "  chunks read ";
+            appendNumber(text, static_cast<long long>(race.chunksRead));
+            text += "  KB read ";
+            appendNumber(text, static_cast<long long>(race.bytesRead / 1024));
+        }
+
+        text += "\nParticles  live ";
+        appendNumber(text, static_cast<long long>(particles.getCount()));
+        text += "  peak ";
+        appendNumber(text, static_cast<long long>(particles.getPeak()));
+
+        if (autopilotEnabled)
+        {
+            const AutopilotStats &pilot = autopilot.getStats();
+            text += "\nAutopilot  decisions ";
+            appendNumber(text, static_cast<long long>(pilot.decisions));
+            text += "  plans ";
+            appendNumber(text, static_cast<long long>(pilot.fullPlans));
+            text += "  repairs ";
+            appendNumber(text, static_cast<long long>(pilot.repairs));
+            text += "  budget hits ";
+            appendNumber(text, static_cast<long long>(pilot.budgetHits));
+            text += "  expanded ";
+            appendNumber(text, static_cast<long long>(pilot.lastExpanded));
+            text += "  cost (us) ";
+            appendNumber(text, static_cast<long long>(pilot.lastCost.asMicroseconds()));
+        }
+
+        statsText.setString(text.c_str());
+    }
+    target->draw(statsText);
+}
+
+void Game::refreshHeatmap()
+{
+    AllocScope scope(AllocTag::Overlay);
+    heatmapRefreshClock.restart();
+
+    // Every stored run plus the one in progress
+    const HeatLayer shown = static_cast<HeatLayer>(heatmapShown);
+    const size_t cells = static_cast<size_t>(HEATMAP_COLUMNS) * HEATMAP_ROWS;
+    auto count = [&](HeatLayer layer, size_t cell)
+    {
+        double stored = heatmapStore.isOpen() ? static_cast<double>(heatmapStore.layer(layer)[cell]) : 0.0;
+        return stored + heatmapRun.layer(layer)[cell];
+    };
+    // Detours are shown per food, a cell isn't bad just because food often lands there
+    auto value = [&](size_t cell)
+    {
+        if (shown != HeatLayer::Detours)
+            return count(shown, cell);
+        double spawns = count(HeatLayer::FoodSpawns, cell);
+        return spawns > 0.0 ? count(HeatLayer::Detours, cell) / spawns : 0.0;
+    };
+
+    double peak = 0.0;
+    for (size_t cell = 0; cell < cells; ++cell)
+        peak = std::max(peak, value(cell));
+
+    // Log scale, so a few very hot cells don't wash out everything else
+    const double scale = peak > 0.0 ? 1.0 / std::log1p(peak) : 0.0;
+    for (size_t cell = 0; cell < cells; ++cell)
+        heatColor(static_cast<float>(std::log1p(value(cell)) * scale), &heatmapPixels[cell * 4]);
+    heatmapTexture.update(heatmapPixels.data());
+
+    std::string label = "Heatmap  " + std::string(heatLayerName(shown));
+    label += shown == HeatLayer::Detours ? "  (extra ticks per food)" : "";
+    label += "  runs " + std::to_string(heatmapStore.isOpen() ? heatmapStore.getSessions() : 0) + " + this one";
+    label += "  peak " + std::to_string(static_cast<long long>(peak)) + "  (H for the next)";
+    heatmapText.setString(label);
+}
+
+void Game::checkFrameAllocations()
+{
+#ifndef NDEBUG
+    // A warmed-up PLAYING frame that didn't grow the snake must not touch the heap. Input and
+    // the overlay are left out, they allocate on OS events and debug refreshes. The death
+    // animation hands its vertex building to the job system, which queues std::functions,
+    // and a rewind step rebuilds the tail from a keyframe. "main --alloccheck" checks every
+    // tag in any build.
+    if (currentState != GameState::PLAYING || playingFrames < ALLOC_WARMUP_FRAMES || frameGrew || dying || rewindHeld)
+        return;
+
+    std::uint64_t steady = frameAllocs[AllocTag::Sim] + frameAllocs[AllocTag::Autopilot] +
+                           frameAllocs[AllocTag::Render] + frameAllocs[AllocTag::Audio];
+    if (steady == 0)
+        return;
+
+    std::cerr << "Steady PLAYING frame made " << steady << " heap allocations:";
+    for (std::size_t tag = 0; tag < ALLOC_TAG_COUNT; ++tag)
+        std::cerr << " " << allocTagName(static_cast<AllocTag>(tag)) << " " << frameAllocs.allocations[tag];
+    std::cerr << std::endl;
+    assert(steady == 0);
+#endif
 }
 
 void Game::drawPause()
 {
-    window.clear();
-    window.draw(menuBackgroundSprite);
-
-    // PAUSED text
-    sf::Text pauseText(font, "PAUSED", 100);
-    sf::FloatRect pauseBounds = pauseText.getLocalBounds();
-    pauseText.setOrigin({pauseBounds.size.x / 2.0f, pauseBounds.size.y / 2.0f});
-    pauseText.setPosition({RESOLUTION_WIDTH / 2.0f, 300});
-    pauseText.setFillColor(sf::Color::White);
-    pauseText.setOutlineThickness(2);
-    pauseText.setOutlineColor(sf::Color::Black);
-    window.draw(pauseText);
-
-    // Resume instructions
-    sf::Text resumeText(font, "Press   Esc   or   P   to   Resume", 40);
-    sf::FloatRect resumeBounds = resumeText.getLocalBounds();
-    resumeText.setOrigin({resumeBounds.size.x / 2.0f, resumeBounds.size.y / 2.0f});
-    resumeText.setPosition({RESOLUTION_WIDTH / 2.0f, 450});
-    resumeText.setFillColor(sf::Color::White);
-    resumeText.setOutlineThickness(2);
-    resumeText.setOutlineColor(sf::Color::Black);
-    window.draw(resumeText);
-
-    // Menu instructions
-    sf::Text menuText(font, "Press   M   for   Main   Menu", 40);
-    sf::FloatRect menuBounds = menuText.getLocalBounds();
-    menuText.setOrigin({menuBounds.size.x / 2.0f, menuBounds.size.y / 2.0f});
-    menuText.setPosition({RESOLUTION_WIDTH / 2.0f, 520});
-    menuText.setFillColor(sf::Color::White);
-    menuText.setOutlineThickness(2);
-    menuText.setOutlineColor(sf::Color::Black);
-    window.draw(menuText);
-
-    // Exit instructions
-    sf::Text exitText(font, "Press   Q   to   Exit   Game", 40);
-    sf::FloatRect exitBounds = exitText.getLocalBounds();
-    exitText.setOrigin({exitBounds.size.x / 2.0f, exitBounds.size.y / 2.0f});
-    exitText.setPosition({RESOLUTION_WIDTH / 2.0f, 590});
-    exitText.setFillColor(sf::Color::White);
-    exitText.setOutlineThickness(2);
-    exitText.setOutlineColor(sf::Color::Black);
-    window.draw(exitText);
+    target->clear();
+    drawMenuBackground();
 
-    window.display();
+    for (const auto &label : pauseLabels)
+        target->draw(label);
+
+    present();
 }
 
 void Game::drawGameOver()
 {
-    window.clear();
-    window.draw(menuBackgroundSprite);
-
-    // Draw game over text
-    sf::Text gameOverDisplay = gameOverText;
-    sf::FloatRect gameOverBounds = gameOverDisplay.getLocalBounds();
-    gameOverDisplay.setOrigin({gameOverBounds.size.x / 2.0f, gameOverBounds.size.y / 2.0f});
-    gameOverDisplay.setPosition({RESOLUTION_WIDTH / 2.0f, 200});
-    gameOverDisplay.setOutlineThickness(2);
-    gameOverDisplay.setOutlineColor(sf::Color::Black);
-    window.draw(gameOverDisplay);
-
-    // Update and draw final score
-    scoreText = sf::Text(font, "Final  Score  " + std::to_string(scoreboard.getCurrentScore()), 60);
-    sf::FloatRect scoreBounds = scoreText.getLocalBounds();
-    scoreText.setOrigin({scoreBounds.size.x / 2.0f, scoreBounds.size.y / 2.0f});
-    scoreText.setPosition({RESOLUTION_WIDTH / 2.0f, 350});
-    scoreText.setFillColor(sf::Color::White);
-    scoreText.setOutlineThickness(2);
-    scoreText.setOutlineColor(sf::Color::Black);
-    window.draw(scoreText);
+    target->clear();
+    drawMenuBackground();
+
+    target->draw(gameOverText);
+    target->draw(scoreText);
 
     // Show new high score message if applicable
     if (isNewHighScore)
-    {
-        sf::Text newHighScoreText(font, "NEW HIGH SCORE!", 50);
-        sf::FloatRect newHighScoreBounds = newHighScoreText.getLocalBounds();
-        newHighScoreText.setOrigin({newHighScoreBounds.size.x / 2.0f, newHighScoreBounds.size.y / 2.0f});
-        newHighScoreText.setPosition({RESOLUTION_WIDTH / 2.0f, 420});
-        newHighScoreText.setFillColor(sf::Color::Yellow);
-        newHighScoreText.setOutlineThickness(2);
-        newHighScoreText.setOutlineColor(sf::Color::Black);
-        window.draw(newHighScoreText);
-    }
+        target->draw(newHighScoreText);
 
-    // Draw instruction text
-    sf::Text instructionsDisplay = instructionText;
-    sf::FloatRect instructionBounds = instructionsDisplay.getLocalBounds();
-    instructionsDisplay.setOrigin({instructionBounds.size.x / 2.0f, instructionBounds.size.y / 2.0f});
-    instructionsDisplay.setPosition({RESOLUTION_WIDTH / 2.0f, 750});
-    window.draw(instructionsDisplay);
+    target->draw(instructionText);
 
-    restartButton->draw(window);
-    menuButton->draw(window);
+    restartButton->draw(*target);
+    menuButton->draw(*target);
 
-    window.display();
+    present();
 }
 
 // ========== USERNAME INPUT AND HIGH SCORE METHODS ==========
@@ -883,27 +1798,11 @@ void Game::handleUsernameInput()
 
 void Game::drawUsernameInput()
 {
-    window.clear();
+    target->clear();
 
-    // Apply zoom effect to background
-    menuBackgroundSprite.setScale({backgroundZoom, backgroundZoom});
+    drawMenuBackground();
 
-    // Center the scaled background
-    sf::FloatRect bgBounds = menuBackgroundSprite.getGlobalBounds();
-    menuBackgroundSprite.setPosition({(RESOLUTION_WIDTH - bgBounds.size.x) / 2.0f,
-                                      (RESOLUTION_HEIGHT - bgBounds.size.y) / 2.0f});
-
-    window.draw(menuBackgroundSprite);
-
-    // Title text
-    sf::Text titleText(font, "Enter   Username", 120);
-    sf::FloatRect titleBounds = titleText.getLocalBounds();
-    titleText.setOrigin({titleBounds.size.x / 2.0f, titleBounds.size.y / 2.0f});
-    titleText.setPosition({RESOLUTION_WIDTH / 2.0f, 200});
-    titleText.setFillColor(sf::Color::White);
-    titleText.setOutlineThickness(3);
-    titleText.setOutlineColor(sf::Color::Black);
-    window.draw(titleText);
+    target->draw(usernameLabels[0]);
 
     // Username input box
     sf::RectangleShape inputBox({600, 80});
@@ -911,35 +1810,20 @@ void Game::drawUsernameInput()
     inputBox.setFillColor(sf::Color::White);
     inputBox.setOutlineThickness(3);
     inputBox.setOutlineColor(sf::Color::Black);
-    window.draw(inputBox);
+    target->draw(inputBox);
 
-    // Username text
-    std::string displayText = inputUsername + "_"; // Add cursor
-    sf::Text usernameText(font, displayText, 60);
-    usernameText.setPosition({(RESOLUTION_WIDTH - 600) / 2.0f + 20, 355});
-    usernameText.setFillColor(sf::Color::Black);
-    window.draw(usernameText);
-
-    // Instructions
-    sf::Text instructionText(font, "Type   your   username   and   press   Enter   to   start", 40);
-    sf::FloatRect instructionBounds = instructionText.getLocalBounds();
-    instructionText.setOrigin({instructionBounds.size.x / 2.0f, instructionBounds.size.y / 2.0f});
-    instructionText.setPosition({RESOLUTION_WIDTH / 2.0f, 500});
-    instructionText.setFillColor(sf::Color::White);
-    instructionText.setOutlineThickness(2);
-    instructionText.setOutlineColor(sf::Color::Black);
-    window.draw(instructionText);
+    // Username text, only reshaped when the input changed
+    if (shownUsername != inputUsername)
+    {
+        shownUsername = inputUsername;
+        usernameText.setString(inputUsername + "_"); // Add cursor
+    }
+    target->draw(usernameText);
 
-    sf::Text escText(font, "Press   Escape   to   go   back", 30);
-    sf::FloatRect escBounds = escText.getLocalBounds();
-    escText.setOrigin({escBounds.size.x / 2.0f, escBounds.size.y / 2.0f});
-    escText.setPosition({RESOLUTION_WIDTH / 2.0f, 600});
-    escText.setFillColor(sf::Color::White);
-    escText.setOutlineThickness(2);
-    escText.setOutlineColor(sf::Color::Black);
-    window.draw(escText);
+    for (size_t i = 1; i < usernameLabels.size(); ++i)
+        target->draw(usernameLabels[i]);
 
-    window.display();
+    present();
 }
 
 void Game::loadHighScore()
@@ -965,6 +1849,8 @@ void Game::loadHighScore()
 
 void Game::saveHighScore()
 {
+    PhaseMarker phase(WatchPhase::HighScore);
+
     std::ofstream file("highscore.txt");
     if (file.is_open())
     {
@@ -973,18 +1859,201 @@ void Game::saveHighScore()
     }
 }
 
+void Game::beginSession()
+{
+    session = SessionRecord();
+    session.startTime = static_cast<std::uint64_t>(std::time(nullptr));
+    session.username = currentUsername;
+    session.autopilot = autopilotEnabled;
+    sessionPlayMs = 0.0;
+    sessionActive = true;
+    heatmapRun.clear();
+}
+
+void Game::endSession()
+{
+    if (!sessionActive)
+        return;
+
+    session.durationMs = static_cast<std::uint32_t>(sessionPlayMs);
+    session.score = scoreboard.getCurrentScore();
+    session.length = static_cast<std::uint32_t>(player.tailSegments.size() + 1);
+
+    // Only runs a person played straight through, the autopilot would teach the heatmaps its own habits
+    if (!session.autopilot && !runRewound)
+    {
+        heatmapStore.merge(heatmapRun);
+        saveGhost();
+    }
+
+    // Handed to the writer thread, the file is touched off the game loop
+    telemetry.submit(std::move(session));
+    sessionActive = false;
+}
+
+void Game::updateFinalScoreText()
+{
+    scoreText.setString("Final  Score  " + std::to_string(scoreboard.getCurrentScore()));
+    centerLabel(scoreText, {RESOLUTION_WIDTH / 2.0f, 350});
+}
+
+void Game::updateGhostModeText()
+{
+    ghostModeText.setString(ghostRacing ? "Ghost   racing   on   (R)" : "Press   R   to   race   your   best   runs");
+    ghostModeText.setFillColor(ghostRacing ? sf::Color::Cyan : sf::Color::White);
+    centerLabel(ghostModeText, {RESOLUTION_WIDTH / 2.0f, 870});
+
+    practiceModeText.setString(practiceMode ? "Practice   on,   hold   Backspace   to   rewind   (P)" : "Press   P   to   practice   with   rewind");
+    practiceModeText.setFillColor(practiceMode ? sf::Color::Cyan : sf::Color::White);
+    centerLabel(practiceModeText, {RESOLUTION_WIDTH / 2.0f, 915});
+}
+
+void Game::updateHighScoreText()
+{
+    highScoreText.setString("High   Score   " + std::to_string(highScore) + "   by   " + highScoreUsername);
+    centerLabel(highScoreText, {RESOLUTION_WIDTH / 2.0f, 750});
+}
+
 void Game::checkAndUpdateHighScore()
 {
+    // Scores from a rewound run don't count
     int currentScore = scoreboard.getCurrentScore();
-    if (currentScore > highScore)
+    if (currentScore > highScore && !runRewound)
     {
         highScore = currentScore;
         highScoreUsername = currentUsername;
         isNewHighScore = true;
         saveHighScore();
+        updateHighScoreText();
     }
     else
     {
         isNewHighScore = false;
     }
+}
+
+// ========== GHOST RACING ==========
+
+void Game::startGhostRace()
+{
+    // The high score run first, then everyone's best with this player's own ahead of the rest
+    std::vector<std::string> files;
+    GhostInfo record;
+    bool haveRecord = readGhostInfo(GHOST_HIGHSCORE_FILE, record);
+    if (haveRecord)
+        files.push_back(GHOST_HIGHSCORE_FILE);
+
+    std::vector<std::pair<GhostInfo, std::string>> bests;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(GHOST_DIR, error))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind(GHOST_BEST_PREFIX, 0) != 0 || entry.path().extension() != GHOST_EXTENSION)
+            continue;
+
+        GhostInfo info;
+        if (!readGhostInfo(entry.path().string(), info))
+            continue;
+        // The high score run is usually also its holder's best
+        if (haveRecord && info.username == record.username && info.score == record.score && info.ticks == record.ticks)
+            continue;
+        bests.push_back({info, entry.path().string()});
+    }
+
+    std::sort(bests.begin(), bests.end(), [this](const auto &a, const auto &b)
+              {
+                  bool aOwn = a.first.username == currentUsername;
+                  bool bOwn = b.first.username == currentUsername;
+                  return aOwn != bOwn ? aOwn : a.first.score > b.first.score;
+              });
+    for (const auto &best : bests)
+        files.push_back(best.second);
+
+    ghosts.start(files);
+}
+
+void Game::saveGhost()
+{
+    if (!ghostRecordingLive || ghostRecording.getTicks() == 0)
+        return;
+    ghostRecordingLive = false;
+
+    // One best run per player, the name made safe for a file name
+    std::string bestFile = currentUsername;
+    for (char &c : bestFile)
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+            c = '_';
+    bestFile = std::string(GHOST_DIR) + "/" + GHOST_BEST_PREFIX + bestFile + GHOST_EXTENSION;
+
+    const int score = scoreboard.getCurrentScore();
+    GhostInfo info;
+    bool newBest = !readGhostInfo(bestFile, info) || score > info.score;
+    bool newRecord = score >= highScore && (!readGhostInfo(GHOST_HIGHSCORE_FILE, info) || score > info.score);
+    if (!newBest && !newRecord)
+        return;
+
+    // Written on a worker like the save, a long run is a few hundred KB
+    if (ghostWrite.valid())
+        ghostWrite.wait();
+    ghostWrite = std::async(std::launch::async, [bytes = ghostRecording.finish(currentUsername, score), bestFile, newBest, newRecord]()
+                            {
+                                bool written = true;
+                                if (newBest)
+                                    written = writeGhostFile(bestFile, bytes) && written;
+                                if (newRecord)
+                                    written = writeGhostFile(GHOST_HIGHSCORE_FILE, bytes) && written;
+                                return written;
+                            });
+}
+
+// ========== SAVE/RESUME METHODS ==========
+
+void Game::saveSnapshot()
+{
+    PhaseMarker phase(WatchPhase::Snapshot);
+
+    GameSnapshot snapshot;
+    player.saveState(snapshot);
+    snapshot.direction = direction;
+    snapshot.foodPosition = food.getSimPosition();
+    snapshot.score = scoreboard.getCurrentScore();
+    snapshot.rngState = food.rng.getState();
+    snapshot.username = currentUsername;
+
+    // Encoding is cheap, the disk write happens on a worker so pausing never stalls a frame
+    if (snapshotWrite.valid())
+        snapshotWrite.wait();
+    snapshotWrite = std::async(std::launch::async, [bytes = snapshot.encode()]()
+                               { return writeSnapshotFile(SNAPSHOT_FILE, bytes); });
+}
+
+bool Game::restoreSnapshot()
+{
+    std::vector<char> bytes;
+    GameSnapshot snapshot;
+    if (!readSnapshotFile(SNAPSHOT_FILE, bytes) || !snapshot.decode(bytes))
+        return false;
+
+    player.loadState(snapshot);
+    direction = snapshot.direction;
+    food.setSimPosition(snapshot.foodPosition);
+    food.rng.setState(snapshot.rngState);
+    scoreboard.setScore(snapshot.score);
+    currentUsername = snapshot.username;
+    inputUsername = snapshot.username;
+    beginSession();
+    ghostRecordingLive = false;
+    return true;
+}
+
+void Game::discardSnapshot()
+{
+    PhaseMarker phase(WatchPhase::Snapshot);
+
+    // Let an in-flight write finish so it can't recreate the file afterwards
+    if (snapshotWrite.valid())
+        snapshotWrite.wait();
+
+    std::error_code error;
+    std::filesystem::remove(SNAPSHOT_FILE, error);
 }
\ No newline at end of file
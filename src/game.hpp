@@ -5,15 +5,53 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <future>
 
 #include "types.hpp"
 #include "player.hpp"
+#include "jobs.hpp"
+#include "arena.hpp"
+#include "camera.hpp"
+#include "input.hpp"
+#include "statsshm.hpp"
+#include "gridboard.hpp"
+#include "autopilot.hpp"
+#include "alloccount.hpp"
+#include "framearena.hpp"
+#include "telemetry.hpp"
+#include "particles.hpp"
+#include "tilemap.hpp"
+#include "sfx.hpp"
+#include "watchdog.hpp"
+#include "parallax.hpp"
+#include "heatmap.hpp"
+#include "framepacer.hpp"
+#include "ghost.hpp"
+#include "rewind.hpp"
 
 #define MUSIC_VOLUME 50.0f
 #define MAX_FPS 120
 #define RESOLUTION_WIDTH 1920u
 #define RESOLUTION_HEIGHT 1080u
+#define WORLD_WIDTH (RESOLUTION_WIDTH * 3)
+#define WORLD_HEIGHT (RESOLUTION_HEIGHT * 3)
 #define FONT "fonts/ARCADECLASSIC.TTF"
+#define STATS_FONT "fonts/ARIAL.TTF"
+#define MAX_SNAKE_SEGMENTS (static_cast<size_t>(WORLD_WIDTH / PLAYER_SIZE) * static_cast<size_t>(WORLD_HEIGHT / PLAYER_SIZE))
+#define STATS_REFRESH_MS 250
+#define ALLOC_WARMUP_FRAMES 60 // PLAYING frames before the zero allocation check kicks in
+#define ALLOC_CHECK_EPISODES 6
+#define BENCH_FRAMES_PER_SCREEN 600
+#define BENCH_SEED 12345u
+#define DEATH_ANIMATION_MS 1200 // Disintegration shown before the game over screen
+#define PARTICLE_STEP (1.0f / MAX_FPS) // The playfield advances one tick per frame, so do the particles
+#define MAP_COLUMNS static_cast<int>(WORLD_WIDTH / MAP_TILE_SIZE)
+#define MAP_ROWS static_cast<int>(WORLD_HEIGHT / MAP_TILE_SIZE)
+#define WALL_COLOR sf::Color(70, 70, 80)
+#define HEATMAP_COLUMNS static_cast<int>(WORLD_WIDTH / HEATMAP_CELL_SIZE)
+#define HEATMAP_ROWS static_cast<int>(WORLD_HEIGHT / HEATMAP_CELL_SIZE)
+#define HEATMAP_REFRESH_MS 500 // The overlay texture is rebuilt this often while shown
+#define HEATMAP_OPACITY 170    // Alpha of the hottest cells
 
 class Button;
 
@@ -24,6 +62,7 @@ public:
 
     void increaseScore(int amount);
     void resetScore();
+    void setScore(int score);
     int getCurrentScore() const { return currentScore; }
     sf::Text text;
 
@@ -35,9 +74,12 @@ private:
 class Game
 {
 public:
-    Game();
+    explicit Game(bool offscreenMode = false);
 
     void run(); // Main game loop with state machine
+    void runFrame(); // One pass of the loop
+    int runRenderBenchmark(int framesPerScreen); // Offscreen timing of every screen, see renderbench.cpp
+    int runAllocCheck(int episodes); // Offscreen autopilot runs that fail on a steady frame allocating, see alloccheck.cpp
     
     // State-specific methods
     void handleMenuState();
@@ -45,35 +87,67 @@ public:
     void handlePlayingState();
     void handlePausedState();
     void handleGameOverState();
+    void handleArenaState();
+    void handleGridState();
     
     void changeState(GameState newState);
     void resetGame();
+    void resetPlayfield(); // resetGame without touching the save or the session log
     
     // Username and high score methods
     void loadHighScore();
     void saveHighScore();
     void checkAndUpdateHighScore();
+
+    // Save/resume of an in-progress run
+    void saveSnapshot();
+    bool restoreSnapshot();
+    void discardSnapshot();
     
     // Rendering methods
     void drawMenu();
+    void drawMenuBackground();
     void drawUsernameInput();
-    void drawGame();
+    void drawGame(); // Captures the playfield, then draws it
+    void capturePlayfield();
+    void drawPlayfield();
     void drawPause();
     void drawGameOver();
+    void drawArena();
+    void drawStats();
+    void drawGrid();
     
     // Input handling methods
     void handleMenuInput();
     void handleUsernameInput();
-    void handleGameInput();
     void handlePauseInput();
     void handleGameOverInput();
+    void handleArenaInput();
+    void handleGridInput();
     
     // Utility methods
-    bool isGameOver();
     void loadBackgroundMusic(const std::string& filename);
+    void loadMap(const std::string& filename);
+    void publishStats();
+    void updateHighScoreText();
+    void updateFinalScoreText();
+    void present();
+    void beginSession();
+    void endSession();
+    void checkFrameAllocations();
+    void refreshHeatmap();
+    void applyPaceMode(PaceMode mode);
+    void startGhostRace();
+    void saveGhost();
+    void updateGhostModeText();
+    void rewindStep();
+    void simulateTick(); // One tick of the pipelined PLAYING frame, on a worker
 
 private:
     sf::RenderWindow window;
+    bool offscreenMode;
+    sf::RenderTexture offscreen;
+    sf::RenderTarget *target = &window; // Where the draw functions go, the window or the offscreen texture
     Player player;
     Food food;
     Scoreboard scoreboard;
@@ -86,11 +160,13 @@ private:
     
     // Resources
     sf::Music backgroundMusic;
-    sf::Texture menuBackgroundTexture;
-    sf::Sprite menuBackgroundSprite;
+    ParallaxBackground menuBackground;
     sf::Texture gameBackgroundTexture;
-    sf::Sprite gameBackgroundSprite;
     sf::Font font;
+
+    // Scrolling playfield
+    Camera camera;
+    ChunkedBackground gameBackground;
     
     // UI Elements
     Button* startButton;
@@ -99,8 +175,9 @@ private:
     Button* menuButton;
     Button* resumeButton;
     
-    // Background zoom effect for menu
+    // Background zoom and drift for menu
     float backgroundZoom = 1.0f;
+    float backgroundSeconds = 0.0f; // Menu time driving the drift
     bool zoomingIn = true;
     const float minZoom = 1.0f;
     const float maxZoom = 1.10f;
@@ -110,6 +187,27 @@ private:
     sf::Text gameOverText;
     sf::Text scoreText;
     sf::Text instructionText;
+
+    // Screen text, laid out once instead of every frame
+    std::vector<sf::Text> menuLabels;
+    std::vector<sf::Text> pauseLabels;
+    std::vector<sf::Text> usernameLabels;
+    sf::Text highScoreText;
+    sf::Text usernameText;
+    std::string shownUsername;
+    sf::Text newHighScoreText;
+
+    // Sound effects
+    SoundEffects sfx;
+
+    // Pipelined PLAYING frame: the next tick is simulated on a worker while this one is drawn
+    Job tickJob;
+    std::vector<SimVector> renderSquares; // Head, tail and corners of the captured tick
+    std::vector<sf::Vertex> snakeVertices;
+    sf::Color snakeColor;
+    sf::RectangleShape foodShape;
+    std::uint64_t renderedTicks = 0;
+    std::uint64_t latencyTick = 0; // First tick that shows the pending turn
     
     // Username and high score system
     std::string currentUsername;
@@ -117,6 +215,114 @@ private:
     int highScore;
     std::string highScoreUsername;
     bool isNewHighScore;
+
+    // Pending background write of the pause snapshot
+    std::future<bool> snapshotWrite;
+
+    // Arena attract mode
+    JobSystem jobs;
+    Arena arena;
+    size_t arenaSnakeCount = ARENA_START_SNAKES;
+    sf::VertexArray arenaVertices;
+    sf::Text arenaStatsText;
+    sf::Clock arenaReportClock;
+    sf::Time arenaTickTime;
+    int arenaTicksMeasured = 0;
+
+    // Input pipeline
+    sf::Clock inputClock;
+    TurnQueue turnQueue;
+    LatencyStats inputLatency;
+    sf::Time latencyStamp;
+    bool latencyPending = false;
+
+    // Stats overlay (F3)
+    bool showStats = false;
+    sf::Font statsFont;
+    sf::Text statsText;
+    sf::Clock statsRefreshClock;
+
+    // Allocation accounting, see alloccount.hpp
+    FrameArena frameArena;
+    AllocCounts frameAllocs;
+    std::uint64_t playingFrames = 0;
+    bool frameGrew = false; // The snake or the ghost recording made room this frame, which allocates
+
+    // Live counters for external monitoring (snakestat)
+    StatsPublisher statsPublisher;
+    sf::Clock frameClock;
+    sf::Clock statsWindowClock;
+    std::uint64_t frameCount = 0;
+    std::uint64_t tickCount = 0;
+    std::uint64_t ticksAtWindowStart = 0;
+    float frameTimeAverageMs = 0.0f;
+    float frameTimeMaxMs = 0.0f;
+    float frameTimeWindowMaxMs = 0.0f;
+    float ticksPerSecond = 0.0f;
+    std::uint64_t assetBytes = 0;
+
+    // Classic grid mode
+    GridBoard gridBoard;
+    TurnQueue gridTurns;
+    sf::Clock gridClock;
+    sf::Time gridAccumulator;
+    int gridTicksPerSecond = GRID_START_TICKS_PER_SECOND;
+    bool gridOver = false;
+    sf::VertexArray gridVertices;
+    sf::Text gridStatusText;
+
+    // Per-run record for the session log
+    TelemetryWriter telemetry;
+    SessionRecord session;
+    bool sessionActive = false;
+    double sessionPlayMs = 0.0;
+
+    // Self-driving snake (T while playing)
+    Autopilot autopilot;
+    bool autopilotEnabled = false;
+
+    // Walls, drawn from one texel per tile scaled up to the world
+    TileMap map;
+    sf::Texture wallTexture;
+    sf::Sprite wallSprite;
+
+    // Eat bursts and the death disintegration
+    ParticleSystem particles;
+    bool dying = false;
+    sf::Clock dyingClock;
+
+    // Where runs go, die and find food, merged into HEATMAP_FILE at the end of every run (H cycles the overlay)
+    HeatmapRecorder heatmapRun;
+    HeatmapStore heatmapStore;
+    int heatmapShown = -1; // HeatLayer on screen, -1 for none
+    std::vector<std::uint8_t> heatmapPixels;
+    sf::Texture heatmapTexture;
+    sf::Sprite heatmapSprite;
+    sf::Text heatmapText;
+    sf::Clock heatmapRefreshClock;
+
+    // Every run is recorded; with racing on (R in the menu) the best earlier runs play alongside
+    GhostRecorder ghostRecording;
+    bool ghostRecordingLive = false; // Not for a run resumed from a save, its start is missing
+    GhostRace ghosts;
+    bool ghostRacing = false;
+    std::vector<sf::Vertex> ghostVertices;
+    std::future<bool> ghostWrite;
+    sf::Text ghostModeText;
+
+    // Practice mode (P in the menu): holding Backspace steps the run back, a rewound run can't set records
+    RewindHistory rewind;
+    bool practiceMode = false;
+    bool rewindHeld = false;
+    bool runRewound = false;
+    sf::Text practiceModeText;
+
+    // Holds frames to MAX_FPS in place of setFramerateLimit, F4 cycles the modes
+    FramePacer pacer;
+    PaceMode paceMode = PaceMode::SleepSpin; // As picked with F4, the pacer may have fallen back from it
+
+    // Logs frames that stall past WATCHDOG_DEADLINE_MS, see watchdog.hpp
+    Watchdog watchdog;
 };
 
 class Button : public sf::RectangleShape
@@ -124,7 +330,7 @@ class Button : public sf::RectangleShape
 public:
     Button(sf::Vector2f size, std::string buttonText);
     
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& target);
     void setHovered(bool hovered);
     void setPressed(bool pressed);
     void updateText();
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "ghost.hpp"
+#include "binaryio.hpp"
+#include "camera.hpp"
+#include "player.hpp"
+#include "spscqueue.hpp"
+
+namespace
+{
+    constexpr size_t fileHeaderSize = 3 * sizeof(std::uint32_t) + sizeof(std::uint64_t) + 1;
+    constexpr size_t chunkHeaderSize = 3 * sizeof(std::uint32_t);
+    constexpr size_t maxUsername = 255;
+    constexpr size_t maxChunkBytes = GHOST_CHUNK_TICKS * 3 * 10; // Three varints a tick at worst
+    constexpr size_t historyTicks = (GHOST_MAX_SEGMENTS + 1) * framesPerCell;
+
+    const sf::Color palette[GHOST_MAX_GHOSTS] = {
+        {255, 255, 255, GHOST_ALPHA}, {80, 220, 255, GHOST_ALPHA}, {255, 90, 230, GHOST_ALPHA}, {255, 240, 80, GHOST_ALPHA},
+        {255, 150, 40, GHOST_ALPHA}, {140, 150, 255, GHOST_ALPHA}, {255, 140, 160, GHOST_ALPHA}, {170, 255, 90, GHOST_ALPHA}};
+
+    template <typename T>
+    void putRaw(std::vector<char> &out, T value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(value));
+    }
+
+    template <typename T>
+    T getRaw(const char *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Leaves the stream at the first chunk
+    bool readHeader(std::ifstream &file, GhostInfo &info)
+    {
+        char header[fileHeaderSize];
+        if (!file.read(header, fileHeaderSize))
+            return false;
+        if (getRaw<std::uint32_t>(header) != GHOST_MAGIC || getRaw<std::uint32_t>(header + 4) != GHOST_VERSION)
+            return false;
+
+        info.score = getRaw<std::int32_t>(header + 8);
+        info.ticks = getRaw<std::uint64_t>(header + 12);
+        info.username.resize(static_cast<unsigned char>(header[fileHeaderSize - 1]));
+        return info.username.empty() || static_cast<bool>(file.read(&info.username[0], info.username.size()));
+    }
+}
+
+struct GhostFrame
+{
+    SimVector head;
+    std::uint32_t length = 1;
+};
+
+// One recording being played. The streamer decodes into frames, the game thread pops a tick at a time.
+struct GhostTrack
+{
+    GhostInfo info;
+    sf::Color color;
+
+    // Streamer side, and start() before the track is handed over
+    std::ifstream file;
+    std::vector<char> chunk;
+    std::atomic<std::uint64_t> decoded{0};
+    std::atomic<bool> ended{false}; // Nothing more will be decoded: the last chunk is in, or the file was cut short
+    SpscQueue<GhostFrame, GHOST_QUEUE_TICKS> frames;
+
+    // Game thread side
+    std::atomic<std::uint64_t> played{0};
+    PositionHistory history;
+    std::uint32_t length = 1;
+    bool finished = false;
+};
+
+static_assert(GHOST_LOOKAHEAD_TICKS + GHOST_CHUNK_TICKS <= GHOST_QUEUE_TICKS, "A decoded chunk must always fit");
+
+// ========== RECORDING ==========
+
+void GhostRecorder::clear()
+{
+    // A few minutes of play up front, growing mid-run is rare after that
+    chunks.clear();
+    chunks.reserve(GHOST_CHUNK_TICKS * 3 * 256);
+    payload.clear();
+    payload.reserve(maxChunkBytes);
+    chunkTicks = 0;
+    ticks = 0;
+}
+
+bool GhostRecorder::record(SimVector head, std::uint32_t length)
+{
+    if (chunkTicks == 0)
+    {
+        putSigned(payload, head.x);
+        putSigned(payload, head.y);
+        putVarint(payload, length);
+        lastMove = {};
+    }
+    else
+    {
+        const SimVector move = {head.x - last.x, head.y - last.y};
+        putSigned(payload, move.x - lastMove.x);
+        putSigned(payload, move.y - lastMove.y);
+        putSigned(payload, static_cast<std::int64_t>(length) - lastLength);
+        lastMove = move;
+    }
+
+    last = head;
+    lastLength = length;
+    ticks++;
+    return ++chunkTicks == GHOST_CHUNK_TICKS && closeChunk();
+}
+
+bool GhostRecorder::closeChunk()
+{
+    if (chunkTicks == 0)
+        return false;
+
+    // Doubled by hand so the caller knows which tick allocated
+    const bool grow = chunks.size() + chunkHeaderSize + payload.size() > chunks.capacity();
+    if (grow)
+        chunks.reserve(std::max(chunks.capacity() * 2, chunks.size() + chunkHeaderSize + payload.size()));
+
+    putRaw<std::uint32_t>(chunks, chunkTicks);
+    putRaw<std::uint32_t>(chunks, static_cast<std::uint32_t>(payload.size()));
+    putRaw<std::uint32_t>(chunks, checksum(payload.data(), payload.size()));
+    chunks.insert(chunks.end(), payload.begin(), payload.end());
+    payload.clear();
+    chunkTicks = 0;
+    return grow;
+}
+
+std::vector<char> GhostRecorder::finish(const std::string &username, int score)
+{
+    closeChunk();
+
+    const size_t nameLength = std::min(username.size(), maxUsername);
+    std::vector<char> bytes;
+    bytes.reserve(fileHeaderSize + nameLength + chunks.size());
+    putRaw<std::uint32_t>(bytes, GHOST_MAGIC);
+    putRaw<std::uint32_t>(bytes, GHOST_VERSION);
+    putRaw<std::int32_t>(bytes, score);
+    putRaw<std::uint64_t>(bytes, ticks);
+    bytes.push_back(static_cast<char>(nameLength));
+    bytes.insert(bytes.end(), username.begin(), username.begin() + nameLength);
+    bytes.insert(bytes.end(), chunks.begin(), chunks.end());
+    return bytes;
+}
+
+bool readGhostInfo(const std::string &filename, GhostInfo &info)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return file.is_open() && readHeader(file, info);
+}
+
+bool writeGhostFile(const std::string &filename, const std::vector<char> &bytes)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+    return writeFileAtomically(filename, bytes);
+}
+
+// ========== PLAYBACK ==========
+
+GhostRace::GhostRace()
+{
+    thread = std::thread(&GhostRace::streamerLoop, this);
+}
+
+GhostRace::~GhostRace()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void GhostRace::start(const std::vector<std::string> &filenames)
+{
+    stop();
+
+    std::vector<std::unique_ptr<GhostTrack>> loaded;
+    for (const std::string &filename : filenames)
+    {
+        if (loaded.size() == GHOST_MAX_GHOSTS)
+            break;
+
+        auto track = std::make_unique<GhostTrack>();
+        track->file.open(filename, std::ios::binary);
+        if (!track->file.is_open() || !readHeader(track->file, track->info))
+            continue;
+
+        track->color = palette[loaded.size()];
+        track->chunk.reserve(maxChunkBytes);
+        track->history.reserve(historyTicks + 1);
+
+        // The streamer hasn't seen this track yet, so the first chunk can be decoded right here
+        if (!decodeChunk(*track))
+            track->ended.store(true, std::memory_order_release);
+        loaded.push_back(std::move(track));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracks.swap(loaded);
+    }
+    underruns = 0;
+    wake.notify_one();
+}
+
+void GhostRace::stop()
+{
+    std::vector<std::unique_ptr<GhostTrack>> old;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tracks.swap(old);
+    }
+}
+
+const GhostInfo &GhostRace::getInfo(size_t ghost) const
+{
+    return tracks[ghost]->info;
+}
+
+bool GhostRace::decodeChunk(GhostTrack &track)
+{
+    char header[chunkHeaderSize];
+    if (!track.file.read(header, chunkHeaderSize))
+        return false;
+
+    const std::uint32_t count = getRaw<std::uint32_t>(header);
+    const std::uint32_t size = getRaw<std::uint32_t>(header + 4);
+    if (count == 0 || count > GHOST_CHUNK_TICKS || size > maxChunkBytes)
+        return false;
+
+    track.chunk.resize(size);
+    if (!track.file.read(track.chunk.data(), size) || checksum(track.chunk.data(), size) != getRaw<std::uint32_t>(header + 8))
+        return false;
+    chunksRead.fetch_add(1, std::memory_order_relaxed);
+    bytesRead.fetch_add(chunkHeaderSize + size, std::memory_order_relaxed);
+
+    ByteReader in(track.chunk.data(), size);
+    GhostFrame frame;
+    SimVector move;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::int64_t x, y, lengthChange;
+        if (i == 0)
+        {
+            std::uint64_t length;
+            if (!in.getSigned(x) || !in.getSigned(y) || !in.getVarint(length))
+                return false;
+            frame.head = {static_cast<SimCoord>(x), static_cast<SimCoord>(y)};
+            frame.length = static_cast<std::uint32_t>(length);
+        }
+        else
+        {
+            if (!in.getSigned(x) || !in.getSigned(y) || !in.getSigned(lengthChange))
+                return false;
+            move.x += static_cast<SimCoord>(x);
+            move.y += static_cast<SimCoord>(y);
+            frame.head.x += move.x;
+            frame.head.y += move.y;
+            frame.length = static_cast<std::uint32_t>(frame.length + lengthChange);
+        }
+
+        // Can't fail, the lookahead leaves room for a whole chunk
+        track.frames.push(GhostFrame(frame));
+    }
+
+    track.decoded.fetch_add(count, std::memory_order_release);
+    return true;
+}
+
+void GhostRace::streamerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping)
+    {
+        wake.wait_for(lock, std::chrono::milliseconds(GHOST_POLL_MS));
+
+        for (auto &track : tracks)
+        {
+            while (!track->ended.load(std::memory_order_relaxed) &&
+                   track->decoded.load(std::memory_order_relaxed) - track->played.load(std::memory_order_acquire) < GHOST_LOOKAHEAD_TICKS)
+            {
+                if (!decodeChunk(*track))
+                    track->ended.store(true, std::memory_order_release);
+            }
+        }
+    }
+}
+
+void GhostRace::tick()
+{
+    for (auto &track : tracks)
+    {
+        if (track->finished)
+            continue;
+
+        GhostFrame frame;
+        if (!track->frames.pop(frame))
+        {
+            // Frames pushed before the end was flagged are visible once it is, so look once more
+            const bool over = track->ended.load(std::memory_order_acquire);
+            if (!over || !track->frames.pop(frame))
+            {
+                if (over)
+                    track->finished = true;
+                else
+                    underruns++; // Stands still for a tick rather than wait on the disk
+                continue;
+            }
+        }
+
+        track->history.pushFront(frame.head);
+        if (track->history.size() > historyTicks)
+            track->history.popBack();
+        track->length = frame.length;
+        track->played.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void GhostRace::appendVertices(std::vector<sf::Vertex> &out, const Camera &camera) const
+{
+    const float half = PLAYER_SIZE / 2;
+    for (const auto &track : tracks)
+    {
+        if (track->finished || track->history.size() == 0)
+            continue;
+
+        // Head, then the body the same way the player's tail follows its history
+        const size_t segments = std::min<size_t>(track->length - 1, GHOST_MAX_SEGMENTS);
+        for (size_t i = 0; i <= segments; ++i)
+        {
+            const size_t index = i * framesPerCell;
+            if (index >= track->history.size())
+                break;
+
+            const sf::Vector2f position = toPixels(track->history[index]);
+            if (!camera.isVisible(position, half))
+                continue;
+
+            const sf::Vector2f topLeft = position - sf::Vector2f(half, half);
+            const sf::Vector2f bottomRight = position + sf::Vector2f(half, half);
+            out.push_back({topLeft, track->color});
+            out.push_back({{bottomRight.x, topLeft.y}, track->color});
+            out.push_back({bottomRight, track->color});
+            out.push_back({topLeft, track->color});
+            out.push_back({bottomRight, track->color});
+            out.push_back({{topLeft.x, bottomRight.y}, track->color});
+        }
+    }
+}
+
+GhostStats GhostRace::getStats() const
+{
+    GhostStats stats;
+    stats.ghosts = static_cast<std::uint32_t>(tracks.size());
+    stats.underruns = underruns;
+    stats.chunksRead = chunksRead.load(std::memory_order_relaxed);
+    stats.bytesRead = bytesRead.load(std::memory_order_relaxed);
+
+    bool any = false;
+    for (const auto &track : tracks)
+    {
+        if (track->finished || track->ended.load(std::memory_order_relaxed))
+            continue;
+        const std::uint64_t ahead = track->decoded.load(std::memory_order_relaxed) - track->played.load(std::memory_order_relaxed);
+        stats.minAhead = any ? std::min(stats.minAhead, static_cast<std::uint32_t>(ahead)) : static_cast<std::uint32_t>(ahead);
+        any = true;
+    }
+    return stats;
+}
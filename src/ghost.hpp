@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "fixedpoint.hpp"
+
+#define GHOST_DIR "ghosts"
+#define GHOST_HIGHSCORE_FILE "ghosts/highscore.ghost"
+#define GHOST_BEST_PREFIX "best_" // Followed by the username, one file per player
+#define GHOST_EXTENSION ".ghost"
+#define GHOST_MAGIC 0x54534847u // "GHST"
+#define GHOST_VERSION 1u
+#define GHOST_CHUNK_TICKS 256     // Ticks per chunk, the unit read from disk and decoded at a time
+#define GHOST_LOOKAHEAD_TICKS 512 // Decoded ahead of playback, a little over four seconds
+#define GHOST_QUEUE_TICKS 1024    // Must fit the lookahead plus one chunk
+#define GHOST_POLL_MS 50          // How often the streamer tops the ghosts up
+#define GHOST_MAX_GHOSTS 8
+#define GHOST_MAX_SEGMENTS 40     // Body squares drawn per ghost, its head history is sized to match
+#define GHOST_ALPHA 90
+
+class Camera;
+struct GhostTrack;
+
+// Header of a recording, all that is read when picking which ghosts to race
+struct GhostInfo
+{
+    std::string username;
+    std::int32_t score = 0;
+    std::uint64_t ticks = 0;
+};
+
+// Head position and snake length for every tick of a run, kept as encoded chunks while
+// it's recorded. A chunk starts with an absolute position and then stores how each move
+// differs from the one before, which is nothing on almost every tick, so about 3 bytes a tick.
+class GhostRecorder
+{
+public:
+    void clear();
+    // True on the rare tick the recording had to make room, the only time it allocates
+    bool record(SimVector head, std::uint32_t length);
+    std::uint64_t getTicks() const { return ticks; }
+
+    // The whole file: header, then {tick count, payload size, FNV-1a checksum, payload} per chunk
+    std::vector<char> finish(const std::string &username, int score);
+
+private:
+    bool closeChunk();
+
+    std::vector<char> chunks;
+    std::vector<char> payload; // Chunk being recorded
+    std::uint32_t chunkTicks = 0;
+    SimVector last;
+    SimVector lastMove;
+    std::uint32_t lastLength = 0;
+    std::uint64_t ticks = 0;
+};
+
+bool readGhostInfo(const std::string &filename, GhostInfo &info);
+// Through a temporary file, a crash never leaves a torn recording behind
+bool writeGhostFile(const std::string &filename, const std::vector<char> &bytes);
+
+struct GhostStats
+{
+    std::uint32_t ghosts = 0;
+    std::uint32_t minAhead = 0;    // Fewest decoded ticks waiting on any ghost still running
+    std::uint64_t underruns = 0;   // Ticks a ghost stood still because decoding fell behind
+    std::uint64_t chunksRead = 0;
+    std::uint64_t bytesRead = 0;
+};
+
+// Plays recordings back as ghost snakes. Only the headers are read up front; a streamer
+// thread reads and decodes each file a chunk at a time, keeping GHOST_LOOKAHEAD_TICKS
+// ready in a fixed ring per ghost. Memory and the work per tick depend on the number of
+// ghosts only, never on how long the recordings are.
+class GhostRace
+{
+public:
+    GhostRace();
+    ~GhostRace();
+
+    GhostRace(const GhostRace &) = delete;
+    GhostRace &operator=(const GhostRace &) = delete;
+
+    // Up to GHOST_MAX_GHOSTS files in the order given, the first chunk of each is decoded before this returns
+    void start(const std::vector<std::string> &filenames);
+    void stop();
+
+    // Game thread, once per PLAYING tick
+    void tick();
+
+    // The visible ghost squares, appended as a triangle list
+    void appendVertices(std::vector<sf::Vertex> &out, const Camera &camera) const;
+
+    bool isRacing() const { return !tracks.empty(); }
+    const GhostInfo &getInfo(size_t ghost) const;
+    size_t getCount() const { return tracks.size(); }
+    GhostStats getStats() const;
+
+private:
+    void streamerLoop();
+    bool decodeChunk(GhostTrack &track);
+
+    std::vector<std::unique_ptr<GhostTrack>> tracks; // Swapped under mutex, the streamer only reads it under it
+    std::uint64_t underruns = 0;
+    std::atomic<std::uint64_t> chunksRead{0};
+    std::atomic<std::uint64_t> bytesRead{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread thread;
+};
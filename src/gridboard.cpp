@@ -0,0 +1,160 @@
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "gridboard.hpp"
+
+namespace
+{
+    int countTrailingZeros(std::uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+}
+
+GridBoard::GridBoard(int columns, int rows)
+    : columns(columns), rows(rows), cellCount(static_cast<std::uint32_t>(columns * rows)),
+      occupancy((cellCount + 63) / 64, 0), body(cellCount, 0)
+{
+}
+
+void GridBoard::reset(std::uint64_t seed)
+{
+    std::fill(occupancy.begin(), occupancy.end(), 0);
+    rngState = seed ? seed : 1;
+    heading = moveDirection::Right;
+
+    // Start as three cells in the middle heading right
+    std::uint32_t center = static_cast<std::uint32_t>((rows / 2) * columns + columns / 2);
+    length = 3;
+    headSlot = 2;
+    for (std::uint32_t i = 0; i < length; ++i)
+    {
+        body[i] = center - 2 + i;
+        setCell(body[i]);
+    }
+
+    spawnFood();
+}
+
+std::uint64_t GridBoard::nextRandom()
+{
+    // xorshift64*, fully specified so a seed gives the same board everywhere
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 2685821657736338717ull;
+}
+
+std::uint32_t GridBoard::getFreeCellCount() const
+{
+    std::uint32_t used = 0;
+    for (std::uint64_t word : occupancy)
+        used += static_cast<std::uint32_t>(popcount64(word));
+    return cellCount - used;
+}
+
+std::uint32_t GridBoard::getBodyCell(std::uint32_t index) const
+{
+    return body[(headSlot + cellCount - index) % cellCount];
+}
+
+bool GridBoard::spawnFood()
+{
+    std::uint32_t freeCells = cellCount - length;
+    if (freeCells == 0)
+    {
+        foodCell = -1;
+        return false;
+    }
+
+    // Pick the n-th free cell: skip whole words by their popcount, then walk bits in one word
+    std::uint32_t target = static_cast<std::uint32_t>(nextRandom() % freeCells);
+    for (size_t word = 0; word < occupancy.size(); ++word)
+    {
+        std::uint64_t freeBits = ~occupancy[word];
+        std::uint32_t bitsInWord = std::min<std::uint32_t>(64, cellCount - static_cast<std::uint32_t>(word * 64));
+        if (bitsInWord < 64)
+            freeBits &= (std::uint64_t{1} << bitsInWord) - 1;
+
+        std::uint32_t freeInWord = static_cast<std::uint32_t>(popcount64(freeBits));
+        if (target >= freeInWord)
+        {
+            target -= freeInWord;
+            continue;
+        }
+
+        for (; target > 0; --target)
+            freeBits &= freeBits - 1;
+        foodCell = static_cast<std::int32_t>(word * 64 + countTrailingZeros(freeBits));
+        return true;
+    }
+
+    foodCell = -1;
+    return false;
+}
+
+GridStep GridBoard::step(moveDirection direction)
+{
+    // Reversing into the neck is ignored, the snake keeps going
+    bool reverse = (direction == moveDirection::Up && heading == moveDirection::Down) ||
+                   (direction == moveDirection::Down && heading == moveDirection::Up) ||
+                   (direction == moveDirection::Left && heading == moveDirection::Right) ||
+                   (direction == moveDirection::Right && heading == moveDirection::Left);
+    if (!reverse)
+        heading = direction;
+
+    std::uint32_t head = body[headSlot];
+    int x = static_cast<int>(head % columns);
+    int y = static_cast<int>(head / columns);
+    switch (heading)
+    {
+    case moveDirection::Up:
+        y--;
+        break;
+    case moveDirection::Down:
+        y++;
+        break;
+    case moveDirection::Left:
+        x--;
+        break;
+    case moveDirection::Right:
+        x++;
+        break;
+    }
+
+    if (x < 0 || y < 0 || x >= columns || y >= rows)
+        return GridStep::Died;
+
+    std::uint32_t next = static_cast<std::uint32_t>(y * columns + x);
+    bool ate = static_cast<std::int32_t>(next) == foodCell;
+
+    // The tail moves out before the head moves in, so following your own tail is legal
+    std::uint32_t tailCell = body[(headSlot + cellCount - (length - 1)) % cellCount];
+    if (!ate)
+        clearCell(tailCell);
+
+    if (isOccupied(next))
+    {
+        setCell(tailCell); // Leave the board as it was at the moment of death
+        return GridStep::Died;
+    }
+
+    headSlot = (headSlot + 1) % cellCount;
+    body[headSlot] = next;
+    setCell(next);
+    if (ate)
+        length++;
+
+    if (!ate)
+        return GridStep::Moved;
+
+    return spawnFood() ? GridStep::Ate : GridStep::Won;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <bitset>
+#include <cstdint>
+
+#include "types.hpp"
+
+#define GRID_COLUMNS 64
+#define GRID_ROWS 36
+#define GRID_CELL_SIZE 30.0f
+#define GRID_START_TICKS_PER_SECOND 12
+#define GRID_MAX_TICKS_PER_SECOND 3840
+
+enum class GridStep
+{
+    Moved,
+    Ate,
+    Died,
+    Won // No free cell left for food
+};
+
+// Classic cell-by-cell snake. The body is a ring buffer of cell indices and occupancy is a
+// packed bitset, so a tick is a handful of bit operations whatever the snake length.
+class GridBoard
+{
+public:
+    GridBoard(int columns, int rows);
+
+    void reset(std::uint64_t seed);
+    GridStep step(moveDirection direction);
+
+    bool isOccupied(std::uint32_t cell) const { return (occupancy[cell >> 6] >> (cell & 63)) & 1u; }
+    std::uint32_t getFreeCellCount() const;
+    std::uint32_t getLength() const { return length; }
+    std::uint32_t getBodyCell(std::uint32_t index) const; // 0 = head
+    std::int32_t getFoodCell() const { return foodCell; }
+    moveDirection getHeading() const { return heading; }
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+
+private:
+    void setCell(std::uint32_t cell) { occupancy[cell >> 6] |= std::uint64_t{1} << (cell & 63); }
+    void clearCell(std::uint32_t cell) { occupancy[cell >> 6] &= ~(std::uint64_t{1} << (cell & 63)); }
+    bool spawnFood();
+    std::uint64_t nextRandom();
+
+    int columns;
+    int rows;
+    std::uint32_t cellCount;
+
+    std::vector<std::uint64_t> occupancy;
+    std::vector<std::uint32_t> body; // Ring buffer with room for every cell
+    std::uint32_t headSlot = 0;
+    std::uint32_t length = 0;
+    std::int32_t foodCell = -1;
+    moveDirection heading = moveDirection::Right;
+    std::uint64_t rngState = 1;
+};
+
+// Portable, the compiler picks POPCNT only where the target is known to have it
+inline int popcount64(std::uint64_t value)
+{
+    return static_cast<int>(std::bitset<64>(value).count());
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "heatmap.hpp"
+#include "player.hpp"
+
+namespace
+{
+    constexpr SimCoord cellSize = toSim(HEATMAP_CELL_SIZE);
+
+    const char *layerNames[] = {"Heads", "Deaths", "Food spawns", "Detours"};
+    static_assert(sizeof(layerNames) / sizeof(layerNames[0]) == HEAT_LAYER_COUNT);
+}
+
+const char *heatLayerName(HeatLayer layer)
+{
+    return layerNames[static_cast<std::size_t>(layer)];
+}
+
+HeatmapRecorder::HeatmapRecorder(int columns, int rows)
+    : columns(columns), rows(rows), counts(HEAT_LAYER_COUNT * columns * rows, 0)
+{
+}
+
+void HeatmapRecorder::clear()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    ticks = 0;
+    foodOut = false;
+}
+
+int HeatmapRecorder::cellAt(SimVector position) const
+{
+    int x = std::clamp(position.x / cellSize, 0, columns - 1);
+    int y = std::clamp(position.y / cellSize, 0, rows - 1);
+    return y * columns + x;
+}
+
+void HeatmapRecorder::add(HeatLayer layer, int cell, std::uint32_t amount)
+{
+    counts[static_cast<std::size_t>(layer) * columns * rows + cell] += amount;
+}
+
+void HeatmapRecorder::tick(SimVector head)
+{
+    add(HeatLayer::Heads, cellAt(head), 1);
+    ticks++;
+}
+
+void HeatmapRecorder::foodSpawned(SimVector food, SimVector head)
+{
+    foodCell = cellAt(food);
+    add(HeatLayer::FoodSpawns, foodCell, 1);
+
+    // The head can't move diagonally, so the shortest way there is the Manhattan distance
+    const SimCoord step = toSim(PLAYER_SPEED);
+    foodStraightTicks = static_cast<std::uint64_t>(std::abs(food.x - head.x) + std::abs(food.y - head.y)) / step;
+    foodTick = ticks;
+    foodOut = true;
+}
+
+void HeatmapRecorder::foodEaten()
+{
+    if (!foodOut)
+        return;
+
+    const std::uint64_t taken = ticks - foodTick;
+    if (taken > foodStraightTicks)
+        add(HeatLayer::Detours, foodCell, static_cast<std::uint32_t>(taken - foodStraightTicks));
+    foodOut = false;
+}
+
+void HeatmapRecorder::death(SimVector head)
+{
+    add(HeatLayer::Deaths, cellAt(head), 1);
+}
+
+bool HeatmapStore::open(const std::string &filename, int columns, int rows)
+{
+    cells = static_cast<std::size_t>(columns) * rows;
+    if (!file.open(filename, sizeof(Header) + HEAT_LAYER_COUNT * cells * sizeof(std::uint64_t)))
+    {
+        std::cerr << "Could not map heatmap file " << filename << std::endl;
+        return false;
+    }
+
+    Header *head = header();
+    if (head->magic != HEATMAP_MAGIC || head->version != HEATMAP_VERSION ||
+        head->columns != static_cast<std::uint32_t>(columns) || head->rows != static_cast<std::uint32_t>(rows))
+    {
+        std::memset(file.data(), 0, file.size());
+        head->magic = HEATMAP_MAGIC;
+        head->version = HEATMAP_VERSION;
+        head->columns = static_cast<std::uint32_t>(columns);
+        head->rows = static_cast<std::uint32_t>(rows);
+    }
+    return true;
+}
+
+void HeatmapStore::merge(const HeatmapRecorder &run)
+{
+    if (!file.isOpen() || static_cast<std::size_t>(run.getColumns()) * run.getRows() != cells)
+        return;
+
+    Header *head = header();
+    for (std::size_t layer = 0; layer < HEAT_LAYER_COUNT; ++layer)
+    {
+        const std::uint32_t *from = run.layer(static_cast<HeatLayer>(layer));
+        std::uint64_t *into = counts() + layer * cells;
+        std::uint64_t total = 0;
+        for (std::size_t cell = 0; cell < cells; ++cell)
+        {
+            into[cell] += from[cell];
+            total += from[cell];
+        }
+        head->totals[layer] += total;
+    }
+    head->sessions++;
+    file.flush();
+}
+
+const std::uint64_t *HeatmapStore::layer(HeatLayer layer) const
+{
+    return counts() + static_cast<std::size_t>(layer) * cells;
+}
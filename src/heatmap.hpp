@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fixedpoint.hpp"
+#include "sharedmemory.hpp"
+
+#define HEATMAP_FILE "heatmap.bin"
+#define HEATMAP_MAGIC 0x54414548u // "HEAT"
+#define HEATMAP_VERSION 1u
+#define HEATMAP_CELL_SIZE 60.0f // Pixels, one snake segment
+
+// What a heatmap counts per cell
+enum class HeatLayer
+{
+    Heads,      // Ticks the head spent in the cell
+    Deaths,     // Where runs ended
+    FoodSpawns, // Where food appeared
+    Detours,    // Ticks beyond the straight path to food that spawned in the cell
+    Count
+};
+
+#define HEAT_LAYER_COUNT static_cast<std::size_t>(HeatLayer::Count)
+
+const char *heatLayerName(HeatLayer layer);
+
+// Counts for one run on a fixed grid over the world. Everything is plain increments into
+// storage sized up front, cheap enough to call every tick.
+class HeatmapRecorder
+{
+public:
+    HeatmapRecorder(int columns, int rows);
+
+    void clear();
+    void tick(SimVector head);
+    void foodSpawned(SimVector food, SimVector head);
+    void foodEaten(); // Charges the detour to where the food spawned
+    void death(SimVector head);
+
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    const std::uint32_t *layer(HeatLayer layer) const { return &counts[static_cast<std::size_t>(layer) * columns * rows]; }
+
+private:
+    int cellAt(SimVector position) const;
+    void add(HeatLayer layer, int cell, std::uint32_t amount);
+
+    int columns;
+    int rows;
+    std::vector<std::uint32_t> counts; // Layer after layer, row-major
+    std::uint64_t ticks = 0;
+
+    // The food currently out, for its detour
+    bool foodOut = false;
+    int foodCell = 0;
+    std::uint64_t foodTick = 0;
+    std::uint64_t foodStraightTicks = 0;
+};
+
+// Every run ever merged, kept in a memory-mapped file. A merge only adds into the mapping,
+// the operating system writes the touched pages back on its own.
+//
+// File layout: Header, then HEAT_LAYER_COUNT layers of columns * rows uint64 counts.
+class HeatmapStore
+{
+public:
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t columns;
+        std::uint32_t rows;
+        std::uint64_t sessions;
+        std::uint64_t totals[HEAT_LAYER_COUNT];
+    };
+
+    // A missing file, or one for another grid, starts over empty
+    bool open(const std::string &filename, int columns, int rows);
+    void merge(const HeatmapRecorder &run);
+
+    bool isOpen() const { return file.isOpen(); }
+    std::uint64_t getSessions() const { return header()->sessions; }
+    const std::uint64_t *layer(HeatLayer layer) const;
+
+private:
+    Header *header() const { return static_cast<Header *>(file.data()); }
+    std::uint64_t *counts() const { return reinterpret_cast<std::uint64_t *>(header() + 1); }
+
+    MappedFile file;
+    std::size_t cells = 0;
+};
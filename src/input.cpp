@@ -0,0 +1,61 @@
+#include "input.hpp"
+
+bool isOppositeDirection(moveDirection a, moveDirection b)
+{
+    return (a == moveDirection::Up && b == moveDirection::Down) ||
+           (a == moveDirection::Down && b == moveDirection::Up) ||
+           (a == moveDirection::Left && b == moveDirection::Right) ||
+           (a == moveDirection::Right && b == moveDirection::Left);
+}
+
+bool TurnQueue::push(moveDirection direction, moveDirection current, sf::Time timestamp)
+{
+    // Compare against the last queued turn, that's the heading this one will follow
+    moveDirection heading = count > 0 ? turns[(first + count - 1) % turns.size()].direction : current;
+    if (direction == heading || isOppositeDirection(direction, heading))
+        return false;
+
+    if (count == turns.size())
+        return false;
+
+    turns[(first + count) % turns.size()] = {direction, timestamp};
+    count++;
+    return true;
+}
+
+bool TurnQueue::popReady(moveDirection current, int framesSinceTurn, int minFramesBetweenTurns, PendingTurn &turn)
+{
+    if (count == 0 || framesSinceTurn < minFramesBetweenTurns)
+        return false;
+
+    turn = turns[first];
+    first = (first + 1) % turns.size();
+    count--;
+
+    // Only possible if the heading changed behind the queue's back, e.g. after a resume
+    if (turn.direction == current || isOppositeDirection(turn.direction, current))
+        return false;
+
+    return true;
+}
+
+void LatencyStats::record(sf::Time latency)
+{
+    last = latency;
+    if (samples == 0 || latency < min)
+        min = latency;
+    if (samples == 0 || latency > max)
+        max = latency;
+    total += latency;
+    samples++;
+}
+
+void LatencyStats::reset()
+{
+    *this = LatencyStats();
+}
+
+sf::Time LatencyStats::getAverage() const
+{
+    return samples > 0 ? total / static_cast<float>(samples) : sf::Time::Zero;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SFML/System.hpp>
+#include <array>
+
+#include "types.hpp"
+
+#define TURN_QUEUE_CAPACITY 4
+
+struct PendingTurn
+{
+    moveDirection direction;
+    sf::Time timestamp; // When the key press was read
+};
+
+// Buffers turns pressed faster than the snake may turn, each one is applied on the earliest legal tick
+class TurnQueue
+{
+public:
+    // Ignores turns that repeat or reverse the direction the snake will be heading in by then
+    bool push(moveDirection direction, moveDirection current, sf::Time timestamp);
+    bool popReady(moveDirection current, int framesSinceTurn, int minFramesBetweenTurns, PendingTurn &turn);
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+
+private:
+    std::array<PendingTurn, TURN_QUEUE_CAPACITY> turns;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+// Running figures for the delay between a key press and the first frame showing it
+class LatencyStats
+{
+public:
+    void record(sf::Time latency);
+    void reset();
+
+    sf::Time getLast() const { return last; }
+    sf::Time getMin() const { return min; }
+    sf::Time getMax() const { return max; }
+    sf::Time getAverage() const;
+    int getSamples() const { return samples; }
+
+private:
+    sf::Time last;
+    sf::Time min;
+    sf::Time max;
+    sf::Time total;
+    int samples = 0;
+};
+
+bool isOppositeDirection(moveDirection a, moveDirection b);
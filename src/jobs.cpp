@@ -0,0 +1,158 @@
+#include <atomic>
+#include <algorithm>
+
+#include "jobs.hpp"
+
+JobSystem::JobSystem(unsigned workerCount)
+    : queue(JOB_QUEUE_CAPACITY, nullptr)
+{
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i)
+        workers.emplace_back([this]()
+                             { workerLoop(); });
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+unsigned JobSystem::defaultWorkerCount()
+{
+    // Leave one core for the main thread, which also runs chunks itself
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+void JobSystem::launch(Job &job, Job::Function function, void *context)
+{
+    job.function = function;
+    job.context = context;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!workers.empty() && queueSize < JOB_QUEUE_CAPACITY)
+        {
+            job.state.store(Job::Queued, std::memory_order_relaxed);
+            queue[(queueHead + queueSize) % JOB_QUEUE_CAPACITY] = &job;
+            queueSize++;
+            wake.notify_one();
+            return;
+        }
+    }
+
+    // Nobody to hand it to
+    job.state.store(Job::Running, std::memory_order_relaxed);
+    run(job);
+}
+
+void JobSystem::wait(Job &job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (job.state.load(std::memory_order_relaxed) == Job::Queued)
+    {
+        // Still in the queue, take it back and run it here rather than wait for a worker
+        for (size_t i = 0; i < queueSize; ++i)
+        {
+            Job *&slot = queue[(queueHead + i) % JOB_QUEUE_CAPACITY];
+            if (slot == &job)
+            {
+                slot = nullptr;
+                break;
+            }
+        }
+        job.state.store(Job::Running, std::memory_order_relaxed);
+        lock.unlock();
+        job.function(job.context);
+        lock.lock();
+    }
+    else
+    {
+        finished.wait(lock, [&job]()
+                      { int state = job.state.load(std::memory_order_relaxed);
+                        return state == Job::Finished || state == Job::Idle; });
+    }
+    job.state.store(Job::Idle, std::memory_order_release);
+}
+
+void JobSystem::run(Job &job)
+{
+    job.function(job.context);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.state.store(Job::Finished, std::memory_order_release);
+    }
+    finished.notify_all();
+}
+
+void JobSystem::workerLoop()
+{
+    while (true)
+    {
+        Job *job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]()
+                      { return stopping || queueSize > 0; });
+            if (stopping && queueSize == 0)
+                return;
+
+            job = queue[queueHead];
+            queueHead = (queueHead + 1) % JOB_QUEUE_CAPACITY;
+            queueSize--;
+            if (job == nullptr)
+                continue; // Its owner ran it already
+            job->state.store(Job::Running, std::memory_order_relaxed);
+        }
+        run(*job);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)> &fn)
+{
+    if (count == 0)
+        return;
+
+    size_t threads = workers.size() + 1;
+    size_t chunk = std::max(minChunk, (count + threads * 4 - 1) / (threads * 4));
+    size_t chunkCount = (count + chunk - 1) / chunk;
+
+    if (chunkCount <= 1 || workers.empty())
+    {
+        fn(0, count);
+        return;
+    }
+
+    // Chunks are handed out through a shared counter so faster threads simply take more of them
+    struct Shared
+    {
+        const std::function<void(size_t, size_t)> &fn;
+        std::atomic<size_t> next;
+        size_t count;
+        size_t chunk;
+    } shared{fn, {0}, count, chunk};
+    auto runChunks = [](void *context)
+    {
+        Shared &work = *static_cast<Shared *>(context);
+        for (size_t begin = work.next.fetch_add(work.chunk); begin < work.count; begin = work.next.fetch_add(work.chunk))
+            work.fn(begin, std::min(begin + work.chunk, work.count));
+    };
+
+    // Helpers nobody got to are taken back by wait(), so this can't deadlock when called from a worker
+    Job helpers[JOB_MAX_HELPERS];
+    size_t helperCount = std::min({workers.size(), chunkCount - 1, static_cast<size_t>(JOB_MAX_HELPERS)});
+    for (size_t i = 0; i < helperCount; ++i)
+        launch(helpers[i], runChunks, &shared);
+
+    runChunks(&shared);
+
+    for (size_t i = 0; i < helperCount; ++i)
+        wait(helpers[i]);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+#define JOB_QUEUE_CAPACITY 256 // Jobs waiting for a worker, launching into a full queue runs the job inline
+#define JOB_MAX_HELPERS 64     // Workers one parallelFor call hands chunks to
+
+// One piece of background work, owned by whoever launches it. Reusable once waited on.
+class Job
+{
+public:
+    using Function = void (*)(void *context);
+
+    Job() = default;
+    Job(const Job &) = delete;
+    Job &operator=(const Job &) = delete;
+
+    bool isPending() const { return state.load(std::memory_order_acquire) != Idle; }
+
+private:
+    friend class JobSystem;
+
+    enum State
+    {
+        Idle,
+        Queued,
+        Running,
+        Finished
+    };
+
+    Function function = nullptr;
+    void *context = nullptr;
+    std::atomic<int> state{Idle};
+};
+
+// Small fixed pool of worker threads for splitting simulation work across cores.
+// The queue is preallocated, so launching and waiting never touch the heap.
+class JobSystem
+{
+public:
+    explicit JobSystem(unsigned workerCount = defaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Calls fn(begin, end) over [0, count) in chunks of at least minChunk.
+    // The calling thread helps out and the call returns once every chunk is done.
+    // Safe to call from inside a job.
+    void parallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)> &fn);
+
+    // Starts function(context) on a worker, or right here when there are none
+    void launch(Job &job, Job::Function function, void *context);
+    // Returns once the job has run. One no worker has picked up yet runs on this thread instead.
+    void wait(Job &job);
+
+    unsigned getWorkerCount() const { return static_cast<unsigned>(workers.size()); }
+    static unsigned defaultWorkerCount();
+
+private:
+    void run(Job &job);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::vector<Job *> queue; // Ring of JOB_QUEUE_CAPACITY, null where a waiter took a job back
+    size_t queueHead = 0;
+    size_t queueSize = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool stopping = false;
+};
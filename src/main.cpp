@@ -1,15 +1,62 @@
 #include <filesystem>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <iostream>
 #include <windows.h>
 
 #include <SFML/Graphics.hpp>
 
 #include "game.hpp"
+#include "agentlink.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Headless, stepped by an external agent over shared memory
+    if (argc > 1 && std::strcmp(argv[1], "--agent") == 0)
+        return runAgentServer();
+
+    // Offscreen render benchmark, optionally followed by the frame count per screen
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+    {
+        long frames = BENCH_FRAMES_PER_SCREEN;
+        if (argc > 2)
+        {
+            char *end = nullptr;
+            frames = std::strtol(argv[2], &end, 10);
+            if (end == argv[2] || *end != '\0' || frames <= 0 || frames > INT_MAX)
+            {
+                std::cerr << "usage: main --bench [frames per screen, a positive number]\n";
+                return 1;
+            }
+        }
+
+        Game game(true);
+        return game.runRenderBenchmark(static_cast<int>(frames));
+    }
+
+    // Offscreen autopilot runs that fail when a steady frame allocates, optionally followed by the run count
+    if (argc > 1 && std::strcmp(argv[1], "--alloccheck") == 0)
+    {
+        long episodes = ALLOC_CHECK_EPISODES;
+        if (argc > 2)
+        {
+            char *end = nullptr;
+            episodes = std::strtol(argv[2], &end, 10);
+            if (end == argv[2] || *end != '\0' || episodes <= 0 || episodes > INT_MAX)
+            {
+                std::cerr << "usage: main --alloccheck [runs, a positive number]\n";
+                return 1;
+            }
+        }
+
+        Game game(true);
+        return game.runAllocCheck(static_cast<int>(episodes));
+    }
+
     Game game;
     
     game.run();
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,241 @@
+#include <cstdint>
+#include <cstdlib>
+
+#include "overlap.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OVERLAP_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define OVERLAP_TARGET(isa)
+#else
+#define OVERLAP_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+static_assert(sizeof(SimVector) == 2 * sizeof(SimCoord), "positions are read as packed x, y integer pairs");
+
+namespace
+{
+    using KernelFn = size_t (*)(const SimCoord *, size_t, size_t, SimCoord, SimCoord, SimCoord, SimCoord);
+
+    // Positions are interleaved x0 y0 x1 y1 ..., so every kernel compares (x, y) lanes in pairs
+    size_t overlapScalar(const SimCoord *xy, size_t begin, size_t end, SimCoord cx, SimCoord cy, SimCoord hw, SimCoord hh)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (std::abs(xy[2 * i] - cx) < hw && std::abs(xy[2 * i + 1] - cy) < hh)
+                return i;
+        }
+        return end;
+    }
+
+#ifdef OVERLAP_X86
+    // Reduces a lane compare mask (bit 2p = x of position p, bit 2p+1 = its y) to the even bits
+    // of positions where both lanes passed
+    inline unsigned pairMask(unsigned laneMask)
+    {
+        return laneMask & (laneMask >> 1) & 0x55555555u;
+    }
+
+    inline unsigned lowestBit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    // SSE2 has no integer abs, so |d| < h is tested as -h < d && d < h
+    OVERLAP_TARGET("sse2")
+    size_t overlapSSE2(const SimCoord *xy, size_t begin, size_t end, SimCoord cx, SimCoord cy, SimCoord hw, SimCoord hh)
+    {
+        const __m128i center = _mm_setr_epi32(cx, cy, cx, cy);
+        const __m128i extents = _mm_setr_epi32(hw, hh, hw, hh);
+        const __m128i negExtents = _mm_setr_epi32(-hw, -hh, -hw, -hh);
+
+        size_t i = begin;
+        for (; i + 2 <= end; i += 2)
+        {
+            __m128i d = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(xy + 2 * i)), center);
+            __m128i inside = _mm_and_si128(_mm_cmplt_epi32(d, extents), _mm_cmpgt_epi32(d, negExtents));
+            unsigned lanes = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(inside)));
+            if (unsigned hits = pairMask(lanes))
+                return i + lowestBit(hits) / 2;
+        }
+        return overlapScalar(xy, i, end, cx, cy, hw, hh);
+    }
+
+    OVERLAP_TARGET("avx2")
+    size_t overlapAVX2(const SimCoord *xy, size_t begin, size_t end, SimCoord cx, SimCoord cy, SimCoord hw, SimCoord hh)
+    {
+        const __m256i center = _mm256_setr_epi32(cx, cy, cx, cy, cx, cy, cx, cy);
+        const __m256i extents = _mm256_setr_epi32(hw, hh, hw, hh, hw, hh, hw, hh);
+
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            // Two vectors per iteration keeps both load ports busy on long bodies
+            __m256i d0 = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(xy + 2 * i)), center));
+            __m256i d1 = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(xy + 2 * i + 8)), center));
+            unsigned lanes0 = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(extents, d0))));
+            unsigned lanes1 = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(extents, d1))));
+            if (unsigned hits = pairMask(lanes0 | (lanes1 << 8)))
+                return i + lowestBit(hits) / 2;
+        }
+        return overlapScalar(xy, i, end, cx, cy, hw, hh);
+    }
+
+    OVERLAP_TARGET("avx512f")
+    size_t overlapAVX512(const SimCoord *xy, size_t begin, size_t end, SimCoord cx, SimCoord cy, SimCoord hw, SimCoord hh)
+    {
+        const __m512i center = _mm512_setr_epi32(cx, cy, cx, cy, cx, cy, cx, cy, cx, cy, cx, cy, cx, cy, cx, cy);
+        const __m512i extents = _mm512_setr_epi32(hw, hh, hw, hh, hw, hh, hw, hh, hw, hh, hw, hh, hw, hh, hw, hh);
+
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8)
+        {
+            __m512i d = _mm512_abs_epi32(_mm512_sub_epi32(_mm512_loadu_si512(xy + 2 * i), center));
+            unsigned lanes = static_cast<unsigned>(_mm512_cmplt_epi32_mask(d, extents));
+            if (unsigned hits = pairMask(lanes))
+                return i + lowestBit(hits) / 2;
+        }
+        return overlapScalar(xy, i, end, cx, cy, hw, hh);
+    }
+
+    bool cpuSupports(OverlapKernel kernel)
+    {
+        switch (kernel)
+        {
+        case OverlapKernel::Scalar:
+            return true;
+#ifdef _MSC_VER
+        case OverlapKernel::SSE2:
+        case OverlapKernel::AVX2:
+        case OverlapKernel::AVX512:
+        {
+            int info[4];
+            __cpuid(info, 1);
+            if (kernel == OverlapKernel::SSE2)
+                return (info[3] & (1 << 26)) != 0;
+
+            // AVX state has to be enabled by the OS as well, not just present in the CPU
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            if (!osxsave)
+                return false;
+            unsigned long long xcr0 = _xgetbv(0);
+
+            __cpuidex(info, 7, 0);
+            if (kernel == OverlapKernel::AVX2)
+                return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+            return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+        }
+#else
+        case OverlapKernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case OverlapKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case OverlapKernel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        }
+        return false;
+    }
+#else
+    bool cpuSupports(OverlapKernel kernel)
+    {
+        return kernel == OverlapKernel::Scalar;
+    }
+#endif
+
+    KernelFn kernelFunction(OverlapKernel kernel)
+    {
+        switch (kernel)
+        {
+#ifdef OVERLAP_X86
+        case OverlapKernel::SSE2:
+            return overlapSSE2;
+        case OverlapKernel::AVX2:
+            return overlapAVX2;
+        case OverlapKernel::AVX512:
+            return overlapAVX512;
+#endif
+        default:
+            return overlapScalar;
+        }
+    }
+
+    struct Dispatch
+    {
+        OverlapKernel best;
+        OverlapKernel active;
+        KernelFn function;
+
+        Dispatch()
+        {
+            best = OverlapKernel::Scalar;
+            for (OverlapKernel kernel : {OverlapKernel::SSE2, OverlapKernel::AVX2, OverlapKernel::AVX512})
+            {
+                if (cpuSupports(kernel))
+                    best = kernel;
+            }
+            active = best;
+            function = kernelFunction(best);
+        }
+    };
+
+    Dispatch &dispatch()
+    {
+        static Dispatch instance;
+        return instance;
+    }
+}
+
+size_t findOverlap(const SimVector *positions, size_t begin, size_t end,
+                   SimVector center, SimVector halfExtents)
+{
+    if (begin >= end)
+        return end;
+
+    return dispatch().function(reinterpret_cast<const SimCoord *>(positions), begin, end,
+                               center.x, center.y, halfExtents.x, halfExtents.y);
+}
+
+OverlapKernel bestOverlapKernel()
+{
+    return dispatch().best;
+}
+
+OverlapKernel activeOverlapKernel()
+{
+    return dispatch().active;
+}
+
+bool setOverlapKernel(OverlapKernel kernel)
+{
+    if (!cpuSupports(kernel))
+        return false;
+
+    dispatch().active = kernel;
+    dispatch().function = kernelFunction(kernel);
+    return true;
+}
+
+const char *overlapKernelName(OverlapKernel kernel)
+{
+    switch (kernel)
+    {
+    case OverlapKernel::SSE2:
+        return "SSE2";
+    case OverlapKernel::AVX2:
+        return "AVX2";
+    case OverlapKernel::AVX512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "fixedpoint.hpp"
+
+// Batched box overlap test: one box against many packed positions of equally sized boxes.
+// Positions overlap when |dx| < halfExtents.x and |dy| < halfExtents.y, the same test
+// the collision code always used, just evaluated several positions at a time in integers.
+
+enum class OverlapKernel
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// Index of the first position in [begin, end) overlapping the box, or end if there is none
+size_t findOverlap(const SimVector *positions, size_t begin, size_t end,
+                   SimVector center, SimVector halfExtents);
+
+// The fastest kernel the CPU supports is picked on first use; these exist for benchmarking
+OverlapKernel bestOverlapKernel();
+OverlapKernel activeOverlapKernel();
+bool setOverlapKernel(OverlapKernel kernel); // False if the CPU can't run it
+const char *overlapKernelName(OverlapKernel kernel);
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include "overlap.hpp"
+
+// Times each overlap kernel the CPU supports on snake-sized bodies, including the
+// worst case where nothing overlaps and the whole body has to be scanned
+
+int main()
+{
+    const size_t lengths[] = {16, 256, 4096, 65536};
+    const SimVector halfExtents{toSim(60.0f), toSim(60.0f)};
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<SimCoord> dist(0, toSim(5760.0f));
+
+    std::cout << std::setw(8) << "length";
+    for (OverlapKernel kernel : {OverlapKernel::Scalar, OverlapKernel::SSE2, OverlapKernel::AVX2, OverlapKernel::AVX512})
+        std::cout << std::setw(12) << overlapKernelName(kernel);
+    std::cout << "   (ns per query, - = unsupported)\n";
+
+    for (size_t length : lengths)
+    {
+        std::vector<SimVector> body(length);
+        for (auto &position : body)
+            position = {dist(gen), dist(gen)};
+
+        // Query far away from every segment so each call scans the full body
+        const SimVector query{toSim(-1000.0f), toSim(-1000.0f)};
+        const size_t repeats = std::max<size_t>(1, 50'000'000 / length);
+
+        std::cout << std::setw(8) << length;
+        for (OverlapKernel kernel : {OverlapKernel::Scalar, OverlapKernel::SSE2, OverlapKernel::AVX2, OverlapKernel::AVX512})
+        {
+            if (!setOverlapKernel(kernel))
+            {
+                std::cout << std::setw(12) << "-";
+                continue;
+            }
+
+            size_t sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t r = 0; r < repeats; ++r)
+                sink += findOverlap(body.data(), 0, body.size(), query, halfExtents);
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            if (sink != repeats * length)
+                std::cout << "!";
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1) << elapsed / repeats;
+        }
+        std::cout << '\n';
+    }
+
+    setOverlapKernel(bestOverlapKernel());
+    std::cout << "runtime dispatch picks " << overlapKernelName(bestOverlapKernel()) << '\n';
+    return 0;
+}
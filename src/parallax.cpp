@@ -0,0 +1,59 @@
+#include <iostream>
+
+#include "parallax.hpp"
+
+ParallaxBackground::ParallaxBackground(sf::Vector2u resolution)
+    : resolution(resolution)
+{
+}
+
+bool ParallaxBackground::addLayer(const std::string &filename, float depth)
+{
+    sf::Texture source;
+    if (!source.loadFromFile(filename))
+    {
+        std::cerr << "Error loading background layer: " << filename << std::endl;
+        return false;
+    }
+
+    auto cache = std::make_unique<sf::RenderTexture>();
+    if (!cache->resize(resolution))
+    {
+        std::cerr << "Could not create the cache for background layer " << filename << std::endl;
+        return false;
+    }
+
+    // Scaled up once with nearest filtering, the pixel art stays crisp
+    sf::Sprite sprite(source);
+    sprite.setScale({static_cast<float>(resolution.x) / source.getSize().x,
+                     static_cast<float>(resolution.y) / source.getSize().y});
+    cache->clear(sf::Color::Transparent);
+    cache->draw(sprite, sf::BlendNone);
+    cache->display();
+    cache->setSmooth(false);
+
+    layers.push_back({std::move(cache), depth});
+    return true;
+}
+
+void ParallaxBackground::draw(sf::RenderTarget &target, float zoom, float drift) const
+{
+    const sf::Vector2f size(resolution);
+    for (const Layer &layer : layers)
+    {
+        // Nearer layers zoom and drift further. The margin keeps the edges off screen at full drift.
+        const float margin = 1.0f + 2.0f * PARALLAX_SWAY * layer.depth;
+        const float scale = (1.0f + (zoom - 1.0f) * layer.depth) * margin;
+
+        sf::Sprite sprite(layer.cache->getTexture());
+        sprite.setOrigin(size / 2.0f);
+        sprite.setScale({scale, scale});
+        sprite.setPosition({size.x / 2.0f + drift * PARALLAX_SWAY * layer.depth * size.x, size.y / 2.0f});
+        target.draw(sprite);
+    }
+}
+
+std::uint64_t ParallaxBackground::getTextureBytes() const
+{
+    return static_cast<std::uint64_t>(resolution.x) * resolution.y * 4 * layers.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#define PARALLAX_SWAY 0.03f         // Sideways drift of the nearest layer, as a fraction of the screen width
+#define PARALLAX_SWAY_SECONDS 24.0f // One drift there and back
+
+// Menu backdrop made of layers at different depths. Each layer is drawn once into a render
+// texture at display resolution; after that zoom and drift are only a sprite transform per
+// layer, so a frame costs one textured quad per layer however large the source art.
+class ParallaxBackground
+{
+public:
+    explicit ParallaxBackground(sf::Vector2u resolution);
+
+    // Depth 0 stays put, 1 moves the most. Added back to front.
+    bool addLayer(const std::string &filename, float depth);
+
+    // Zoom 1 fills the screen, drift runs from -1 to 1
+    void draw(sf::RenderTarget &target, float zoom, float drift) const;
+
+    std::uint64_t getTextureBytes() const;
+
+private:
+    struct Layer
+    {
+        std::unique_ptr<sf::RenderTexture> cache; // Sprites point at it, so it must not move
+        float depth;
+    };
+
+    sf::Vector2u resolution;
+    std::vector<Layer> layers;
+};
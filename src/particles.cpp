@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+
+#include "particles.hpp"
+#include "player.hpp"
+
+ParticleSystem::ParticleSystem(JobSystem &jobs)
+    : jobs(jobs),
+      positionX(PARTICLE_CAPACITY),
+      positionY(PARTICLE_CAPACITY),
+      velocityX(PARTICLE_CAPACITY),
+      velocityY(PARTICLE_CAPACITY),
+      life(PARTICLE_CAPACITY),
+      fadeRate(PARTICLE_CAPACITY),
+      halfSize(PARTICLE_CAPACITY),
+      color(PARTICLE_CAPACITY),
+      vertices(static_cast<size_t>(PARTICLE_CAPACITY) * 6)
+{
+}
+
+void ParticleSystem::clear()
+{
+    count = 0;
+}
+
+void ParticleSystem::seed(std::uint32_t state)
+{
+    rngState = state != 0 ? state : 1;
+}
+
+float ParticleSystem::random()
+{
+    // xorshift32, plenty for scattering particles and cheaper than a distribution per draw
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return (rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(float x, float y, float vx, float vy, float lifetime, float size, sf::Color tint)
+{
+    if (count == PARTICLE_CAPACITY)
+        return;
+
+    positionX[count] = x;
+    positionY[count] = y;
+    velocityX[count] = vx;
+    velocityY[count] = vy;
+    life[count] = lifetime;
+    fadeRate[count] = 1.0f / lifetime;
+    halfSize[count] = size / 2;
+    color[count] = tint;
+    count++;
+    peak = std::max(peak, count);
+}
+
+void ParticleSystem::burst(sf::Vector2f center, sf::Color tint, size_t amount, float speed, float lifetime)
+{
+    for (size_t i = 0; i < amount; ++i)
+    {
+        float angle = random() * 6.2831853f;
+        float velocity = speed * (0.3f + 0.7f * random());
+        emit(center.x, center.y, std::cos(angle) * velocity, std::sin(angle) * velocity,
+             lifetime * (0.5f + 0.5f * random()), 4.0f + 6.0f * random(), tint);
+    }
+}
+
+void ParticleSystem::breakSquare(sf::Vector2f center, float size, sf::Color tint, int pieces)
+{
+    const float pieceSize = size / pieces;
+    for (int y = 0; y < pieces; ++y)
+    {
+        for (int x = 0; x < pieces; ++x)
+        {
+            // Pieces fly away from the middle of their square, with some scatter
+            float offsetX = (x + 0.5f) * pieceSize - size / 2;
+            float offsetY = (y + 0.5f) * pieceSize - size / 2;
+            float vx = offsetX * 4.0f + (random() - 0.5f) * 120.0f;
+            float vy = offsetY * 4.0f + (random() - 0.5f) * 120.0f;
+            emit(center.x + offsetX, center.y + offsetY, vx, vy, 0.8f + 0.6f * random(), pieceSize, tint);
+        }
+    }
+}
+
+void ParticleSystem::disintegrate(const Player &player)
+{
+    // Keep the pieces per square down so even a snake filling the world fits in the pool
+    const size_t squares = 1 + player.tailSegments.size() + player.cornerSegments.size();
+    const size_t room = PARTICLE_CAPACITY - count;
+    int pieces = static_cast<int>(std::sqrt(static_cast<double>(room / squares)));
+    pieces = std::clamp(pieces, 1, PARTICLE_SEGMENT_PIECES);
+
+    const sf::Color tint = player.getFillColor();
+    breakSquare(player.getPosition(), PLAYER_SIZE, tint, pieces);
+    for (const auto &segment : player.tailSegments)
+        breakSquare(segment.getPosition(), PLAYER_SIZE, segment.getFillColor(), pieces);
+    for (const auto &corner : player.cornerSegments)
+        breakSquare(toPixels(corner.position), PLAYER_SIZE, tint, pieces);
+}
+
+void ParticleSystem::update(float dt)
+{
+    // Integrate. Separate arrays and no branches, so this compiles to packed float math.
+    float *px = positionX.data();
+    float *py = positionY.data();
+    float *vx = velocityX.data();
+    float *vy = velocityY.data();
+    float *left = life.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        vx[i] *= PARTICLE_DRAG;
+        vy[i] *= PARTICLE_DRAG;
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        left[i] -= dt;
+    }
+
+    // Expired particles are replaced by the last live one, the order doesn't matter
+    for (size_t i = count; i-- > 0;)
+    {
+        if (left[i] > 0.0f)
+            continue;
+
+        size_t last = --count;
+        px[i] = px[last];
+        py[i] = py[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        left[i] = left[last];
+        fadeRate[i] = fadeRate[last];
+        halfSize[i] = halfSize[last];
+        color[i] = color[last];
+    }
+}
+
+void ParticleSystem::buildVertices(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const float x = positionX[i];
+        const float y = positionY[i];
+        const float h = halfSize[i];
+        sf::Color tint = color[i];
+        tint.a = static_cast<std::uint8_t>(std::min(life[i] * fadeRate[i], 1.0f) * tint.a);
+
+        sf::Vertex *quad = &vertices[i * 6];
+        quad[0] = {{x - h, y - h}, tint};
+        quad[1] = {{x + h, y - h}, tint};
+        quad[2] = {{x + h, y + h}, tint};
+        quad[3] = {{x - h, y - h}, tint};
+        quad[4] = {{x + h, y + h}, tint};
+        quad[5] = {{x - h, y + h}, tint};
+    }
+}
+
+void ParticleSystem::draw(sf::RenderTarget &target)
+{
+    if (count == 0)
+        return;
+
+    // A handful of eat bursts stays on this thread, a disintegration is split across the workers
+    if (count <= PARTICLE_CHUNK)
+        buildVertices(0, count);
+    else
+        jobs.parallelFor(count, PARTICLE_CHUNK, [this](size_t begin, size_t end)
+                         { buildVertices(begin, end); });
+
+    target.draw(vertices.data(), count * 6, sf::PrimitiveType::Triangles);
+}
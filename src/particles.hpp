@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "jobs.hpp"
+
+#define PARTICLE_CAPACITY 262144 // Fixed pool, emitting into a full pool drops the new particles
+#define PARTICLE_CHUNK 32768     // Particles per job when building vertices
+#define PARTICLE_DRAG 0.96f      // Velocity kept per frame
+#define PARTICLE_EAT_COUNT 96
+#define PARTICLE_SEGMENT_PIECES 8 // Pieces per side a segment breaks into on death, fewer for very long snakes
+
+class Player;
+
+// Short-lived colored squares for eat bursts and the death disintegration.
+// Structure of arrays with a fixed capacity, so nothing is allocated after construction and the
+// update loop runs over plain float arrays the compiler can vectorize.
+class ParticleSystem
+{
+public:
+    explicit ParticleSystem(JobSystem &jobs);
+
+    void clear();
+    void seed(std::uint32_t state);
+
+    // Sprays count particles out of center at up to speed pixels per second
+    void burst(sf::Vector2f center, sf::Color color, size_t count, float speed, float lifetime);
+
+    // Breaks the head and every tail segment into pieces that drift apart and fade
+    void disintegrate(const Player &player);
+
+    void update(float dt);
+    void draw(sf::RenderTarget &target); // One draw call for every live particle
+
+    size_t getCount() const { return count; }
+    size_t getPeak() const { return peak; }
+
+private:
+    void emit(float x, float y, float vx, float vy, float lifetime, float size, sf::Color color);
+    void buildVertices(size_t begin, size_t end);
+    float random(); // 0..1
+    void breakSquare(sf::Vector2f center, float size, sf::Color color, int pieces);
+
+    JobSystem &jobs;
+
+    size_t count = 0;
+    size_t peak = 0;
+    std::uint32_t rngState = 1;
+
+    // One entry per particle, live particles are packed at the front
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> life;        // Seconds left
+    std::vector<float> fadeRate;    // 1 / lifetime, alpha is life * fadeRate
+    std::vector<float> halfSize;
+    std::vector<sf::Color> color;
+
+    std::vector<sf::Vertex> vertices; // Six per particle, two triangles
+};
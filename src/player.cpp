@@ -1,20 +1,25 @@
 #include <random>
 #include <algorithm>
+#include <cstdlib>
 
 #include "player.hpp"
 #include "game.hpp"
+#include "snapshot.hpp"
+#include "overlap.hpp"
+#include "tilemap.hpp"
+#include "jobs.hpp"
 
 // Constructor
 Player::Player()
     : sf::RectangleShape({PLAYER_SIZE, PLAYER_SIZE})
 {
     setOrigin({PLAYER_SIZE / 2, PLAYER_SIZE / 2});
-    setPosition({RESOLUTION_WIDTH / 2, RESOLUTION_HEIGHT / 2});
+    setSimPosition({toSim(WORLD_WIDTH / 2), toSim(WORLD_HEIGHT / 2)});
 }
 
 // Constructor
 Food::Food()
-    : sf::RectangleShape({FOOD_SIZE, FOOD_SIZE})
+    : sf::RectangleShape({FOOD_SIZE, FOOD_SIZE}), rng(std::random_device{}())
 {
     setOrigin({FOOD_SIZE / 2, FOOD_SIZE / 2});
     setFillColor(sf::Color::Red);
@@ -27,62 +32,97 @@ Tail::Tail()
     setOrigin({PLAYER_SIZE / 2, PLAYER_SIZE / 2});
 }
 
-// Check if player died (collided with window borders)
-bool Player::collidedWithBorder()
+namespace
 {
-    auto playerPos = getPosition();
-
-    if (playerPos.y - (PLAYER_SIZE / 2) < 0 ||
-        playerPos.y + (PLAYER_SIZE / 2) > RESOLUTION_HEIGHT ||
-        playerPos.x - (PLAYER_SIZE / 2) < 0 ||
-        playerPos.x + (PLAYER_SIZE / 2) > RESOLUTION_WIDTH)
-        return true;
+    // First distance along the sweep where the point is within reach of target on both axes, -1 if never
+    SimCoord entryDistance(const SimSweep &sweep, SimVector target, SimVector reach)
+    {
+        const bool alongX = sweep.axis == 0;
+        SimCoord across = alongX ? target.y - sweep.start.y : target.x - sweep.start.x;
+        if (std::abs(across) >= (alongX ? reach.y : reach.x))
+            return -1;
+
+        // Inside while ahead - reach < distance < ahead + reach
+        SimCoord ahead = sweep.sign * (alongX ? target.x - sweep.start.x : target.y - sweep.start.y);
+        SimCoord alongReach = alongX ? reach.x : reach.y;
+        SimCoord first = std::max<SimCoord>(0, ahead - alongReach + 1);
+        if (first > sweep.length || first >= ahead + alongReach)
+            return -1;
+        return first;
+    }
 
-    else
-        return false;
+    // Box around the whole sweep for the batched overlap kernels, never smaller than the exact test
+    void sweepBounds(const SimSweep &sweep, SimVector reach, SimVector &center, SimVector &halfExtents)
+    {
+        SimVector end = sweep.at(sweep.length);
+        center = {(sweep.start.x + end.x) / 2, (sweep.start.y + end.y) / 2};
+        halfExtents = reach;
+        (sweep.axis == 0 ? halfExtents.x : halfExtents.y) += (sweep.length + 1) / 2;
+    }
 }
 
-bool Player::collidedWithSelf()
+SimSweep Player::getSweep() const
 {
-    if (tailSegments.size() < 3)
-        return false;
+    // Last tick's position is already in the history, so snapshots restore the sweep too
+    return makeSweep(positionHistory.size() > 1 ? positionHistory[1] : simPosition, simPosition);
+}
 
-    auto playerPos = getPosition();
+// Check if player died (collided with world borders)
+SimCoord Player::borderHit() const
+{
+    const SimSweep sweep = getSweep();
+    const SimCoord half = toSim(PLAYER_SIZE / 2);
+    const SimVector limit{toSim(WORLD_WIDTH), toSim(WORLD_HEIGHT)};
+
+    const SimVector start = sweep.start;
+    if (start.y - half < 0 || start.y + half > limit.y || start.x - half < 0 || start.x + half > limit.x)
+        return 0;
+
+    // The borders are half planes, so only the one ahead can be crossed
+    SimCoord along = sweep.axis == 0 ? start.x : start.y;
+    SimCoord first = sweep.sign > 0 ? (sweep.axis == 0 ? limit.x : limit.y) - half - along + 1 : along - half + 1;
+    return first <= sweep.length ? first : -1;
+}
 
-    for (size_t i = 0; i < tailSegments.size(); ++i)
+SimCoord Player::selfHit() const
+{
+    if (tailSegments.size() < 3)
+        return -1;
+
+    const SimSweep sweep = getSweep();
+    const SimVector reach{toSim(PLAYER_SIZE), toSim(PLAYER_SIZE)};
+    SimVector center, halfExtents;
+    sweepBounds(sweep, reach, center, halfExtents);
+
+    // The kernels find candidates along the whole move, the few hits get the exact test.
+    // Skip the first 2 segments to prevent instant collision after turning.
+    SimCoord first = -1;
+    const size_t count = tailPositions.size();
+    for (size_t i = findOverlap(tailPositions.data(), 2, count, center, halfExtents);
+         i < count;
+         i = findOverlap(tailPositions.data(), i + 1, count, center, halfExtents))
     {
         if (tailSegments[i].isFrozen)
             continue;
-
-        // Skip the first 2 segments to prevent instant collision after turning
-        if (i < 2)
-            continue;
-
-        auto segmentPos = tailSegments[i].getPosition();
-
-        float dx = std::abs(playerPos.x - segmentPos.x);
-        float dy = std::abs(playerPos.y - segmentPos.y);
-
-        if (dx < PLAYER_SIZE * 1.0f && dy < PLAYER_SIZE * 1.0f)
-            return true;
+        SimCoord distance = entryDistance(sweep, tailPositions[i], reach);
+        if (distance >= 0 && (first < 0 || distance < first))
+            first = distance;
     }
 
-    return false;
+    return first;
 }
 
-// Check if player collides with food, return true if it did
-bool Player::eat(Food &food)
+// Constant time per tile crossed whatever the number of walls, see TileMap
+SimCoord Player::wallHit(const TileMap &map) const
 {
-    auto playerPos = getPosition();
-    auto foodPos = food.getPosition();
-
-    float dx = std::abs(playerPos.x - foodPos.x);
-    float dy = std::abs(playerPos.y - foodPos.y);
+    return map.firstWallHit(getSweep(), toSim(PLAYER_SIZE / 2));
+}
 
-    if (dx < (PLAYER_SIZE + FOOD_SIZE) / 2 && dy < (PLAYER_SIZE + FOOD_SIZE) / 2)
-        return true;
-    else
-        return false;
+// Check if player collides with food
+SimCoord Player::foodHit(const Food &food) const
+{
+    const SimVector reach{toSim((PLAYER_SIZE + FOOD_SIZE) / 2), toSim((PLAYER_SIZE + FOOD_SIZE) / 2)};
+    return entryDistance(getSweep(), food.getSimPosition(), reach);
 }
 
 void Player::moveSnake(moveDirection direction)
@@ -95,21 +135,31 @@ void Player::moveSnake(moveDirection direction)
     }
     previousDirection = direction;
 
+    const SimCoord step = toSim(PLAYER_SPEED);
+    SimVector next = simPosition;
+
     switch (direction)
     {
     case moveDirection::Up:
-        move({0.0f, -PLAYER_SPEED});
+        next.y -= step;
         break;
     case moveDirection::Down:
-        move({0.0f, +PLAYER_SPEED});
+        next.y += step;
         break;
     case moveDirection::Left:
-        move({-PLAYER_SPEED, 0.0f});
+        next.x -= step;
         break;
     case moveDirection::Right:
-        move({+PLAYER_SPEED, 0.0f});
+        next.x += step;
         break;
     }
+    setSimPosition(next);
+}
+
+void Player::setSimPosition(SimVector position)
+{
+    simPosition = position;
+    setPosition(toPixels(position));
 }
 
 void Player::incrementFramesSinceTurn()
@@ -120,16 +170,7 @@ void Player::incrementFramesSinceTurn()
 void Player::createCorner()
 {
     // Create a corner segment at the current player position
-    sf::RectangleShape corner({PLAYER_SIZE, PLAYER_SIZE});
-    corner.setOrigin({PLAYER_SIZE / 2, PLAYER_SIZE / 2});
-    corner.setPosition(getPosition());
-    corner.setFillColor(getFillColor());
-
-    CornerSegment cornerData;
-    cornerData.shape = corner;
-    cornerData.position = getPosition();
-
-    cornerSegments.push_back(cornerData);
+    cornerSegments.push_back({simPosition});
 }
 
 void Player::updateCorners()
@@ -141,14 +182,14 @@ void Player::updateCorners()
     }
 
     // Remove corners when the last tail segment has fully passed them
-    sf::Vector2f lastTailPos = tailSegments.back().getPosition();
+    const SimVector lastTailPos = tailPositions.back();
 
     cornerSegments.erase(
         std::remove_if(cornerSegments.begin(), cornerSegments.end(), [lastTailPos](const CornerSegment &corner)
                        {
-                float dx = std::abs(lastTailPos.x - corner.position.x);
-                float dy = std::abs(lastTailPos.y - corner.position.y);
-                return (dx <= 1.0f && dy <= 1.0f); }),
+                SimCoord dx = std::abs(lastTailPos.x - corner.position.x);
+                SimCoord dy = std::abs(lastTailPos.y - corner.position.y);
+                return (dx <= SIM_ONE && dy <= SIM_ONE); }),
         cornerSegments.end());
 }
 
@@ -157,36 +198,104 @@ void Player::spawnTail()
     Tail tail;
 
     // Spawn at the exact position of the last segment (or player if first)
-    if (!tailSegments.empty())
-    {
-        tail.setPosition(tailSegments.back().getPosition());
-    }
-    else
-    {
-        tail.setPosition(getPosition());
-    }
+    const SimVector position = tailPositions.empty() ? simPosition : tailPositions.back();
+    tail.setPosition(toPixels(position));
 
     // Freeze until a whole segment has passed to look like it grows
-    int framesPerSegment = static_cast<int>(segmentSpacing / PLAYER_SPEED);
-    tail.freezeFrames = framesPerSegment;
+    tail.freezeFrames = framesPerCell;
     tail.isFrozen = true;
 
     tailSegments.push_back(tail);
+    tailPositions.push_back(position);
 }
 
 void Player::storePosition()
 {
-    positionHistory.insert(positionHistory.begin(), getPosition());
-    size_t maxHistory = (tailSegments.size() + 5) * (segmentSpacing / PLAYER_SPEED) + 50;
+    positionHistory.pushFront(simPosition);
+    size_t maxHistory = historyLength(tailSegments.size());
     if (positionHistory.size() > maxHistory)
-        positionHistory.pop_back();
+        positionHistory.popBack();
 }
 
-void Player::updateTail()
+void Player::reserve(size_t segments)
 {
-    int framesPerSegment = static_cast<int>(segmentSpacing / PLAYER_SPEED);
+    tailSegments.reserve(segments);
+    tailPositions.reserve(segments);
+    cornerSegments.reserve(cornerCapacity(segments));
+    positionHistory.reserve(historyCapacity(segments));
+}
 
-    for (size_t i = 0; i < tailSegments.size(); ++i)
+void PositionHistory::reserve(size_t capacity)
+{
+    if (capacity > buffer.size())
+        grow(capacity);
+}
+
+void PositionHistory::pushFront(SimVector position)
+{
+    if (count == buffer.size())
+        grow(count + 1);
+
+    first = (first - 1) & (buffer.size() - 1);
+    buffer[first] = position;
+    count++;
+}
+
+void PositionHistory::popBack()
+{
+    if (count > 0)
+        count--;
+}
+
+void PositionHistory::clear()
+{
+    first = 0;
+    count = 0;
+}
+
+void PositionHistory::copyTo(std::vector<SimVector> &out) const
+{
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        out[i] = (*this)[i];
+}
+
+void PositionHistory::assign(const std::vector<SimVector> &positions)
+{
+    clear();
+    reserve(positions.size());
+    for (size_t i = positions.size(); i-- > 0;)
+        pushFront(positions[i]);
+}
+
+void PositionHistory::grow(size_t capacity)
+{
+    size_t newSize = 16;
+    while (newSize < capacity)
+        newSize *= 2;
+
+    // Unwrap into the new buffer, newest first
+    std::vector<SimVector> grown(newSize);
+    for (size_t i = 0; i < count; ++i)
+        grown[i] = (*this)[i];
+
+    buffer.swap(grown);
+    first = 0;
+}
+
+void Player::updateTail(JobSystem *jobs)
+{
+    // Every segment only reads the history and writes itself, so any split gives the same result
+    if (jobs != nullptr && tailSegments.size() > TAIL_PARALLEL_CHUNK)
+        jobs->parallelFor(tailSegments.size(), TAIL_PARALLEL_CHUNK, [this](size_t begin, size_t end)
+                          { updateTailRange(begin, end); });
+    else
+        updateTailRange(0, tailSegments.size());
+}
+
+void Player::updateTailRange(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
     {
         if (tailSegments[i].isFrozen)
         {
@@ -199,54 +308,212 @@ void Player::updateTail()
             continue;
         }
 
-        size_t index = (i + 1) * framesPerSegment;
+        size_t index = (i + 1) * framesPerCell;
         if (index < positionHistory.size())
         {
-            tailSegments[i].setPosition(positionHistory[index]);
+            tailPositions[i] = positionHistory[index];
+            tailSegments[i].setPosition(toPixels(tailPositions[i]));
         }
     }
 }
 
-void Food::spawn(Player &player)
+void SpawnRng::reseed(std::uint32_t seed)
+{
+    // Same initialisation as std::mt19937::seed
+    state.words[0] = seed;
+    for (std::uint32_t i = 1; i < SPAWN_RNG_WORDS; ++i)
+    {
+        std::uint32_t previous = state.words[i - 1];
+        state.words[i] = 1812433253u * (previous ^ (previous >> 30)) + i;
+    }
+    state.index = SPAWN_RNG_WORDS;
+}
+
+bool SpawnRng::setState(const SpawnRngState &saved)
+{
+    if (saved.index > SPAWN_RNG_WORDS)
+        return false;
+    state = saved;
+    return true;
+}
+
+SpawnRng::result_type SpawnRng::operator()()
+{
+    if (state.index >= SPAWN_RNG_WORDS)
+        twist();
+
+    std::uint32_t value = state.words[state.index++];
+    value ^= value >> 11;
+    value ^= (value << 7) & 0x9D2C5680u;
+    value ^= (value << 15) & 0xEFC60000u;
+    value ^= value >> 18;
+    return value;
+}
+
+void SpawnRng::twist()
+{
+    for (std::uint32_t i = 0; i < SPAWN_RNG_WORDS; ++i)
+    {
+        std::uint32_t bits = (state.words[i] & 0x80000000u) | (state.words[(i + 1) % SPAWN_RNG_WORDS] & 0x7FFFFFFFu);
+        std::uint32_t next = state.words[(i + 397) % SPAWN_RNG_WORDS] ^ (bits >> 1);
+        if (bits & 1u)
+            next ^= 0x9908B0DFu;
+        state.words[i] = next;
+    }
+    state.index = 0;
+}
+
+void Player::saveState(GameSnapshot &snapshot) const
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> distX(FOOD_SIZE / 2, RESOLUTION_WIDTH - FOOD_SIZE / 2);
-    std::uniform_real_distribution<float> distY(FOOD_SIZE / 2, RESOLUTION_HEIGHT - FOOD_SIZE / 2);
+    snapshot.headPosition = simPosition;
+    snapshot.previousDirection = previousDirection;
+    snapshot.framesSinceTurn = framesSinceTurn;
+
+    snapshot.tail.clear();
+    snapshot.tail.reserve(tailSegments.size());
+    for (size_t i = 0; i < tailSegments.size(); ++i)
+        snapshot.tail.push_back({tailPositions[i], tailSegments[i].freezeFrames, tailSegments[i].isFrozen});
+
+    snapshot.corners.clear();
+    snapshot.corners.reserve(cornerSegments.size());
+    for (const auto &corner : cornerSegments)
+        snapshot.corners.push_back(corner.position);
 
-    bool validPosition = false;
-    sf::Vector2f newPos;
+    positionHistory.copyTo(snapshot.positionHistory);
+}
 
-    // Make sure the food doesn't spawn where the snake is
-    while (!validPosition)
+void Player::loadState(const GameSnapshot &snapshot)
+{
+    setSimPosition(snapshot.headPosition);
+    previousDirection = snapshot.previousDirection;
+    framesSinceTurn = snapshot.framesSinceTurn;
+
+    tailSegments.clear();
+    tailSegments.reserve(snapshot.tail.size());
+    tailPositions.clear();
+    tailPositions.reserve(snapshot.tail.size());
+    for (const auto &state : snapshot.tail)
     {
-        float x = distX(gen);
-        float y = distY(gen);
-        newPos = {x, y};
+        Tail tail;
+        tail.setPosition(toPixels(state.position));
+        tail.freezeFrames = state.freezeFrames;
+        tail.isFrozen = state.isFrozen;
+        tailSegments.push_back(tail);
+        tailPositions.push_back(state.position);
+    }
+
+    cornerSegments.clear();
+    cornerSegments.reserve(snapshot.corners.size());
+    for (const auto &position : snapshot.corners)
+        cornerSegments.push_back({position});
+
+    positionHistory.assign(snapshot.positionHistory);
+}
+
+void Food::setSimPosition(SimVector position)
+{
+    simPosition = position;
+    setPosition(toPixels(position));
+}
+
+namespace
+{
+    // Maps one 32-bit draw onto [low, low + range) with a multiply instead of
+    // uniform_*_distribution, whose output differs between standard libraries
+    SimCoord drawCoord(SpawnRng &rng, SimCoord low, SimCoord range)
+    {
+        return low + static_cast<SimCoord>((static_cast<std::uint64_t>(rng()) * static_cast<std::uint64_t>(range)) >> 32);
+    }
+}
+
+bool Food::spawn(Player &player, const TileMap &map)
+{
+    // Rejection sampling first, it's cheap while most of the world is open
+    PhaseMarker phase(WatchPhase::FoodSpawn);
+
+    const SimCoord half = toSim(FOOD_SIZE / 2);
+    const SimCoord rangeX = toSim(WORLD_WIDTH) - 2 * half;
+    const SimCoord rangeY = toSim(WORLD_HEIGHT) - 2 * half;
+
+    const SimVector reach{toSim((PLAYER_SIZE + FOOD_SIZE) / 2), toSim((PLAYER_SIZE + FOOD_SIZE) / 2)};
+    const SimVector playerPos = player.getSimPosition();
+
+    // Make sure the food doesn't spawn where the snake is, or where the snake can't reach it
+    for (int attempt = 0; attempt < FOOD_SPAWN_ATTEMPTS; ++attempt)
+    {
+        SimCoord x = drawCoord(rng, half, rangeX);
+        SimCoord y = drawCoord(rng, half, rangeY);
+        SimVector newPos{x, y};
+
+        if (map.clearanceAt(newPos) < MAP_FOOD_CLEARANCE)
+            continue;
 
         // Check head overlap
-        sf::Vector2f playerPos = player.getPosition();
-        float dx = std::abs(playerPos.x - newPos.x);
-        float dy = std::abs(playerPos.y - newPos.y);
-        if (dx < (PLAYER_SIZE + FOOD_SIZE) / 2 && dy < (PLAYER_SIZE + FOOD_SIZE) / 2)
+        if (findOverlap(&playerPos, 0, 1, newPos, reach) == 0)
             continue;
 
         // Check tail overlap
-        bool overlap = false;
-        for (const auto &segment : player.tailSegments)
+        const size_t count = player.tailPositions.size();
+        if (findOverlap(player.tailPositions.data(), 0, count, newPos, reach) == count)
         {
-            sf::Vector2f segPos = segment.getPosition();
-            float sdx = std::abs(segPos.x - newPos.x);
-            float sdy = std::abs(segPos.y - newPos.y);
-            if (sdx < (PLAYER_SIZE + FOOD_SIZE) / 2 && sdy < (PLAYER_SIZE + FOOD_SIZE) / 2)
-            {
-                overlap = true;
-                break;
-            }
+            setSimPosition(newPos);
+            return true;
         }
-        if (!overlap)
-            validPosition = true;
     }
 
-    setPosition({newPos});
+    return spawnInFreeCell(player, map);
+}
+
+bool Food::spawnInFreeCell(const Player &player, const TileMap &map)
+{
+    // A nearly full world: every snake cell center is a candidate, the ones the snake or the
+    // walls rule out are crossed off and a random one of the rest is taken
+    const int columns = static_cast<int>(WORLD_WIDTH / PLAYER_SIZE);
+    const int rows = static_cast<int>(WORLD_HEIGHT / PLAYER_SIZE);
+    const SimCoord step = toSim(PLAYER_SIZE);
+    const SimCoord first = toSim(PLAYER_SIZE / 2);
+    const SimCoord reach = toSim((PLAYER_SIZE + FOOD_SIZE) / 2);
+    auto center = [&](int cell) { return first + cell * step; };
+
+    std::vector<std::uint8_t> taken(static_cast<size_t>(columns) * rows, 0);
+    auto cross = [&](SimVector square)
+    {
+        // Only the cells around the square can be within reach of it
+        const int x0 = std::max(0, (square.x - reach - first) / step);
+        const int x1 = std::min(columns - 1, (square.x + reach - first) / step + 1);
+        const int y0 = std::max(0, (square.y - reach - first) / step);
+        const int y1 = std::min(rows - 1, (square.y + reach - first) / step + 1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                if (std::abs(center(x) - square.x) < reach && std::abs(center(y) - square.y) < reach)
+                    taken[static_cast<size_t>(y) * columns + x] = 1;
+    };
+    cross(player.getSimPosition());
+    for (const SimVector &position : player.tailPositions)
+        cross(position);
+
+    std::uint32_t freeCells = 0;
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < columns; ++x)
+        {
+            std::uint8_t &cell = taken[static_cast<size_t>(y) * columns + x];
+            if (!cell && map.clearanceAt({center(x), center(y)}) < MAP_FOOD_CLEARANCE)
+                cell = 1;
+            if (!cell)
+                freeCells++;
+        }
+    }
+    if (freeCells == 0)
+        return false;
+
+    std::uint32_t pick = static_cast<std::uint32_t>((static_cast<std::uint64_t>(rng()) * freeCells) >> 32);
+    for (size_t i = 0; i < taken.size(); ++i)
+    {
+        if (taken[i] || pick-- > 0)
+            continue;
+        setSimPosition({center(static_cast<int>(i % columns)), center(static_cast<int>(i / columns))});
+        break;
+    }
+    return true;
 }
\ No newline at end of file
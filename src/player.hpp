@@ -1,45 +1,96 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 #include <SFML/Graphics.hpp>
 
 #include "types.hpp"
+#include "fixedpoint.hpp"
 
 #define PLAYER_SPEED 4.0f // Pixels per second
 #define PLAYER_SIZE 60.0f // X and Y pixel length
 #define FOOD_SIZE 25.0f
+#define FOOD_SPAWN_ATTEMPTS 256 // Random spots tried before falling back to a scan of the free cells
+#define TAIL_PARALLEL_CHUNK 1024 // Tail segments per job when a long tail is split across workers
 
 // Forward declarations
 class Tail;
 class Food;
 struct CornerSegment;
+struct GameSnapshot;
+class TileMap;
+class JobSystem;
 
 constexpr int framesPerSegment = 10;
+constexpr int framesPerCell = static_cast<int>(PLAYER_SIZE / PLAYER_SPEED); // Frames between tail segments, a segment length of head movement
 
+// Head positions, newest first. A ring so storing one per frame doesn't shift the whole history.
+class PositionHistory
+{
+public:
+    void reserve(size_t capacity);
+    void pushFront(SimVector position);
+    void popBack();
+    void clear();
+
+    size_t size() const { return count; }
+    const SimVector &operator[](size_t index) const { return buffer[(first + index) & (buffer.size() - 1)]; }
+
+    // Plain copies, newest first, for snapshots
+    void copyTo(std::vector<SimVector> &out) const;
+    void assign(const std::vector<SimVector> &positions);
+
+private:
+    void grow(size_t capacity);
+
+    std::vector<SimVector> buffer; // Power of two size
+    size_t first = 0;
+    size_t count = 0;
+};
+
+// The sim works on SimVector positions; the inherited shape position is only a render copy
 class Player : public sf::RectangleShape
 {
 public:
     Player();
 
-    std::vector<sf::Vector2f> positionHistory;
+    PositionHistory positionHistory;
     std::vector<Tail> tailSegments;
+    std::vector<SimVector> tailPositions; // Sim positions of the tail, packed for the overlap kernels
     std::vector<CornerSegment> cornerSegments;
     int framesSinceTurn = 0;
     
-    bool collidedWithBorder();
-    bool collidedWithSelf();
-    bool eat(Food &food);
+    // Swept along the head's move since last tick: how far into the move the head first
+    // touches, -1 if it doesn't. A fast head can't skip over food or a thin part of the body.
+    SimCoord borderHit() const;
+    SimCoord selfHit() const;
+    SimCoord wallHit(const TileMap &map) const;
+    SimCoord foodHit(const Food &food) const;
+    SimSweep getSweep() const;
     void moveSnake(moveDirection direction);
     void createCorner();
     void updateCorners();
     void spawnTail();
     void storePosition();
-    void updateTail();
+    void updateTail(JobSystem *jobs = nullptr); // Long tails are split across the workers when given some
     void incrementFramesSinceTurn();
+    void reserve(size_t segments); // Room for a snake this long without reallocating
+    // What reserve() sets aside, for anything that copies a snake in and out
+    static size_t cornerCapacity(size_t segments) { return segments + 1; }
+    static size_t historyCapacity(size_t segments) { return historyLength(segments) + 1; }
+    void saveState(GameSnapshot &snapshot) const;
+    void loadState(const GameSnapshot &snapshot);
+
+    SimVector getSimPosition() const { return simPosition; }
+    void setSimPosition(SimVector position);
 
 private:
-    float segmentSpacing = static_cast<float>(static_cast<int>(PLAYER_SIZE / PLAYER_SPEED)) * PLAYER_SPEED;
+    void updateTailRange(size_t begin, size_t end);
+    // Head positions kept for a tail this long, one more is pushed before the oldest goes
+    static size_t historyLength(size_t segments) { return (segments + 5) * framesPerCell + 50; }
+
+    SimVector simPosition;
     int frameCount = 0;
     moveDirection previousDirection = moveDirection::Right;
 };
@@ -54,11 +105,43 @@ private:
     bool isFrozen {true};
 
     friend class Player;
+    friend class Autopilot;
 };
 
+// Drawn with one shared shape, so a turn only stores a position
 struct CornerSegment {
-    sf::RectangleShape shape;
-    sf::Vector2f position;
+    SimVector position;
+};
+
+// Mersenne twister with the same output as std::mt19937, but its state is plain words so
+// snapshots and rewind keyframes can copy it instead of replaying every draw
+#define SPAWN_RNG_WORDS 624
+
+struct SpawnRngState
+{
+    std::uint32_t words[SPAWN_RNG_WORDS];
+    std::uint32_t index;
+};
+
+class SpawnRng
+{
+public:
+    using result_type = std::uint32_t;
+
+    explicit SpawnRng(std::uint32_t seed) { reseed(seed); }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+    result_type operator()();
+
+    void reseed(std::uint32_t seed);
+    const SpawnRngState &getState() const { return state; }
+    bool setState(const SpawnRngState &saved);
+
+private:
+    void twist();
+
+    SpawnRngState state;
 };
 
 class Food : public sf::RectangleShape
@@ -66,5 +149,16 @@ class Food : public sf::RectangleShape
 public:
     Food();
 
-    void spawn(Player& player);
+    // False when no spot is left anywhere, the food then stays where it was
+    bool spawn(Player& player, const TileMap& map);
+
+    SimVector getSimPosition() const { return simPosition; }
+    void setSimPosition(SimVector position);
+
+    SpawnRng rng;
+
+private:
+    bool spawnInFreeCell(const Player &player, const TileMap &map);
+
+    SimVector simPosition;
 };
\ No newline at end of file
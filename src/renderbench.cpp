@@ -0,0 +1,184 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "game.hpp"
+#include "sim.hpp"
+
+// "main --bench [frames]": draws every screen into the offscreen texture with no frame limit,
+// then prints frame rate, draw time and a hash of the last frame of each screen. The session is
+// scripted and seeded, so the hashes only change when the rendered output does.
+
+namespace
+{
+    struct ScreenResult
+    {
+        std::string name;
+        int frames = 0;
+        double seconds = 0.0;
+        double drawAverageMs = 0.0;
+        double drawP95Ms = 0.0;
+        std::uint64_t hash = 0;
+    };
+
+    std::uint64_t hashImage(const sf::Image &image)
+    {
+        // 64-bit FNV-1a over the RGBA pixels
+        const std::uint8_t *pixels = image.getPixelsPtr();
+        size_t size = static_cast<size_t>(image.getSize().x) * image.getSize().y * 4;
+        std::uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= pixels[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Serpentine through the world two cells per row, so even long snakes never hit anything
+    class ScriptedRoute
+    {
+    public:
+        moveDirection next(SimVector head)
+        {
+            if (heading == moveDirection::Down)
+            {
+                if (++downFrames >= static_cast<int>(2 * PLAYER_SIZE / PLAYER_SPEED))
+                    heading = nextRow;
+                return heading;
+            }
+
+            if (heading == moveDirection::Right && head.x >= toSim(WORLD_WIDTH - 2 * PLAYER_SIZE))
+                turnDown(moveDirection::Left);
+            else if (heading == moveDirection::Left && head.x <= toSim(2 * PLAYER_SIZE))
+                turnDown(moveDirection::Right);
+            return heading;
+        }
+
+    private:
+        void turnDown(moveDirection after)
+        {
+            heading = moveDirection::Down;
+            nextRow = after;
+            downFrames = 0;
+        }
+
+        moveDirection heading = moveDirection::Right;
+        moveDirection nextRow = moveDirection::Right;
+        int downFrames = 0;
+    };
+}
+
+int Game::runRenderBenchmark(int framesPerScreen)
+{
+    if (!offscreenMode)
+        return 1;
+
+    std::vector<ScreenResult> results;
+
+    // Times only the draw call; update runs untimed before it
+    auto measure = [&](const std::string &name, const std::function<void()> &update, const std::function<void()> &draw)
+    {
+        ScreenResult result;
+        result.name = name;
+        result.frames = framesPerScreen;
+
+        std::vector<double> drawMs;
+        drawMs.reserve(framesPerScreen);
+        sf::Clock total;
+        for (int frame = 0; frame < framesPerScreen; ++frame)
+        {
+            update();
+            sf::Clock clock;
+            draw();
+            drawMs.push_back(clock.getElapsedTime().asMicroseconds() / 1000.0);
+        }
+
+        // Reading the pixels back waits for the GPU, so it is part of the total
+        sf::Image image = offscreen.getTexture().copyToImage();
+        result.seconds = total.getElapsedTime().asSeconds();
+        result.hash = hashImage(image);
+
+        double sum = 0.0;
+        for (double ms : drawMs)
+            sum += ms;
+        result.drawAverageMs = drawMs.empty() ? 0.0 : sum / drawMs.size();
+        std::sort(drawMs.begin(), drawMs.end());
+        result.drawP95Ms = drawMs.empty() ? 0.0 : drawMs[std::min(drawMs.size() - 1, drawMs.size() * 95 / 100)];
+        results.push_back(result);
+    };
+    auto nothing = [] {};
+
+    // Fixed screen state, no zoom animation or high score flash
+    backgroundZoom = 1.0f;
+    backgroundSeconds = 0.0f;
+    isNewHighScore = false;
+    highScore = 0;
+    highScoreUsername = "Bench";
+    updateHighScoreText();
+
+    measure("MENU", nothing, [&] { drawMenu(); });
+
+    for (size_t length : {0, 50, 200, 800})
+    {
+        resetPlayfield();
+        player.setSimPosition({toSim(2 * PLAYER_SIZE), toSim(2 * PLAYER_SIZE)});
+        food.rng.reseed(BENCH_SEED);
+        food.spawn(player, map);
+
+        ScriptedRoute route;
+        auto step = [&]
+        {
+            direction = route.next(player.getSimPosition());
+            advanceTick(player, direction);
+        };
+
+        // Grow untimed, one segment per segment length travelled
+        for (int frame = 0; player.tailSegments.size() < length; ++frame)
+        {
+            if (frame % framesPerCell == 0)
+                player.spawnTail();
+            step();
+        }
+        for (int frame = 0; frame < framesPerCell; ++frame)
+            step();
+
+        measure("PLAYING " + std::to_string(length + 1), step, [&] { drawGame(); });
+    }
+
+    // Peak particle load: the longest snake breaking apart, again each time the last piece fades
+    dying = true;
+    particles.clear();
+    particles.seed(BENCH_SEED);
+    auto disintegrate = [&]
+    {
+        if (particles.getCount() == 0)
+            particles.disintegrate(player);
+        particles.update(PARTICLE_STEP);
+    };
+    measure("DEATH " + std::to_string(player.tailSegments.size() + 1), disintegrate, [&] { drawGame(); });
+    dying = false;
+
+    measure("PAUSED", nothing, [&] { drawPause(); });
+
+    scoreboard.setScore(static_cast<int>(player.tailSegments.size()) * 10);
+    updateFinalScoreText();
+    measure("GAME_OVER", nothing, [&] { drawGameOver(); });
+
+    std::cout << std::left << std::setw(14) << "screen" << std::right << std::setw(8) << "frames"
+              << std::setw(10) << "fps" << std::setw(12) << "draw avg ms" << std::setw(12) << "draw p95 ms"
+              << "  framebuffer hash\n";
+    for (const auto &result : results)
+    {
+        std::cout << std::left << std::setw(14) << result.name << std::right << std::setw(8) << result.frames
+                  << std::setw(10) << std::fixed << std::setprecision(1) << result.frames / std::max(result.seconds, 1e-9)
+                  << std::setw(12) << std::setprecision(3) << result.drawAverageMs
+                  << std::setw(12) << result.drawP95Ms
+                  << "  " << std::hex << std::setw(16) << std::setfill('0') << result.hash << std::dec << std::setfill(' ') << '\n';
+    }
+
+    return 0;
+}
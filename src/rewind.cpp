@@ -0,0 +1,214 @@
+#include <cstring>
+
+#include "rewind.hpp"
+#include "player.hpp"
+#include "sim.hpp"
+
+namespace
+{
+    // Everything in a keyframe besides the three arrays
+    struct KeyframeHeader
+    {
+        SimVector head;
+        SimVector food;
+        std::int32_t framesSinceTurn;
+        std::int32_t score;
+        SpawnRngState rngState;
+        std::uint32_t tailCount;
+        std::uint32_t cornerCount;
+        std::uint32_t historyCount;
+        moveDirection direction;
+        moveDirection previousDirection;
+    };
+
+    template <typename T>
+    char *putArray(char *out, const std::vector<T> &values)
+    {
+        if (!values.empty())
+            std::memcpy(out, values.data(), values.size() * sizeof(T));
+        return out + values.size() * sizeof(T);
+    }
+
+    template <typename T>
+    const char *getArray(const char *in, std::vector<T> &values, std::size_t count)
+    {
+        values.resize(count);
+        if (count > 0)
+            std::memcpy(values.data(), in, count * sizeof(T));
+        return in + count * sizeof(T);
+    }
+}
+
+RewindHistory::RewindHistory(std::size_t maxSegments)
+    : maxSegments(maxSegments)
+{
+}
+
+void RewindHistory::start(const Player &player, const Food &food, moveDirection direction, int score)
+{
+    // Only taken on the first practice run
+    if (pool.empty())
+    {
+        deltas.resize(REWIND_TICKS);
+        pool.resize(REWIND_BUDGET_BYTES);
+
+        // Same sizes Player::reserve uses, so copying a snake in and out never reallocates
+        scratch.tail.reserve(maxSegments);
+        scratch.corners.reserve(Player::cornerCapacity(maxSegments));
+        scratch.positionHistory.reserve(Player::historyCapacity(maxSegments));
+    }
+
+    tick = 0;
+    poolHead = 0;
+    firstKeyframe = 0;
+    keyframeCount = 0;
+    lastReplayTicks = 0;
+    started = true;
+    writeKeyframe(player, food, direction, score);
+}
+
+void RewindHistory::record(const Player &player, const Food &food, moveDirection direction, int score, bool ate)
+{
+    if (!started)
+        return;
+
+    tick++;
+    Delta &delta = deltas[tick % REWIND_TICKS];
+    delta.score = score;
+    delta.direction = direction;
+    delta.ate = ate;
+
+    // A keyframe is only any use while the deltas after it are still in the ring
+    while (keyframeCount > 0 && keyframeAt(0).tick + REWIND_TICKS < tick)
+        dropOldest();
+
+    if (tick % REWIND_KEYFRAME_TICKS == 0)
+        writeKeyframe(player, food, direction, score);
+}
+
+void RewindHistory::dropOldest()
+{
+    firstKeyframe = (firstKeyframe + 1) % REWIND_MAX_KEYFRAMES;
+    keyframeCount--;
+}
+
+void RewindHistory::writeKeyframe(const Player &player, const Food &food, moveDirection direction, int score)
+{
+    player.saveState(scratch);
+
+    KeyframeHeader header{};
+    header.head = scratch.headPosition;
+    header.food = food.getSimPosition();
+    header.framesSinceTurn = scratch.framesSinceTurn;
+    header.score = score;
+    header.rngState = food.rng.getState();
+    header.tailCount = static_cast<std::uint32_t>(scratch.tail.size());
+    header.cornerCount = static_cast<std::uint32_t>(scratch.corners.size());
+    header.historyCount = static_cast<std::uint32_t>(scratch.positionHistory.size());
+    header.direction = direction;
+    header.previousDirection = scratch.previousDirection;
+
+    const std::size_t bytes = sizeof(header) + scratch.tail.size() * sizeof(TailState) +
+                              (scratch.corners.size() + scratch.positionHistory.size()) * sizeof(SimVector);
+    if (bytes > pool.size())
+    {
+        // Longer than the whole budget: nothing older can be reached from here on
+        keyframeCount = 0;
+        return;
+    }
+
+    // Written round the pool, overwriting the oldest keyframes in the way
+    if (poolHead + bytes > pool.size())
+        poolHead = 0;
+    auto overlaps = [&](const Keyframe &keyframe)
+    { return keyframe.offset < poolHead + bytes && poolHead < keyframe.offset + keyframe.bytes; };
+    while (keyframeCount > 0)
+    {
+        bool inTheWay = keyframeCount == REWIND_MAX_KEYFRAMES;
+        for (std::size_t i = 0; i < keyframeCount && !inTheWay; ++i)
+            inTheWay = overlaps(keyframeAt(i));
+        if (!inTheWay)
+            break;
+        dropOldest();
+    }
+
+    char *out = pool.data() + poolHead;
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    out = putArray(out, scratch.tail);
+    out = putArray(out, scratch.corners);
+    putArray(out, scratch.positionHistory);
+
+    keyframeAt(keyframeCount) = {tick, poolHead, bytes};
+    keyframeCount++;
+    poolHead += bytes;
+}
+
+void RewindHistory::readKeyframe(const Keyframe &keyframe, Player &player, Food &food, moveDirection &direction, int &score)
+{
+    KeyframeHeader header;
+    const char *in = pool.data() + keyframe.offset;
+    std::memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+    in = getArray(in, scratch.tail, header.tailCount);
+    in = getArray(in, scratch.corners, header.cornerCount);
+    getArray(in, scratch.positionHistory, header.historyCount);
+
+    scratch.headPosition = header.head;
+    scratch.previousDirection = header.previousDirection;
+    scratch.framesSinceTurn = header.framesSinceTurn;
+    player.loadState(scratch);
+
+    food.setSimPosition(header.food);
+    food.rng.setState(header.rngState);
+    direction = header.direction;
+    score = header.score;
+}
+
+bool RewindHistory::stepBack(Player &player, Food &food, const TileMap &map, moveDirection &direction, int &score)
+{
+    if (!started || keyframeCount == 0 || tick == keyframeAt(0).tick)
+        return false;
+
+    // The newest keyframe at or before the wanted tick, later ones describe a future that is gone
+    const std::uint64_t target = tick - 1;
+    while (keyframeAt(keyframeCount - 1).tick > target)
+        keyframeCount--;
+    const Keyframe &keyframe = keyframeAt(keyframeCount - 1);
+    poolHead = keyframe.offset + keyframe.bytes;
+
+    readKeyframe(keyframe, player, food, direction, score);
+    for (std::uint64_t replay = keyframe.tick + 1; replay <= target; ++replay)
+    {
+        const Delta &delta = deltas[replay % REWIND_TICKS];
+        TickResult result = checkTick(player, food, map);
+        advanceTick(player, delta.direction);
+        direction = delta.direction;
+        score = delta.score;
+
+        // Only if something outside the sim changed the snake. Play carries on from here, with no more rewinding.
+        if (result.ate != delta.ate || result.death != DeathCause::None)
+        {
+            keyframeCount = 0;
+            return false;
+        }
+    }
+
+    lastReplayTicks = static_cast<std::uint32_t>(target - keyframe.tick);
+    tick = target;
+    return true;
+}
+
+RewindStats RewindHistory::getStats() const
+{
+    RewindStats stats;
+    stats.keyframes = static_cast<std::uint32_t>(keyframeCount);
+    stats.lastReplayTicks = lastReplayTicks;
+    if (!started || keyframeCount == 0)
+        return stats;
+
+    stats.availableTicks = static_cast<std::uint32_t>(tick - keyframeAt(0).tick);
+    for (std::size_t i = 0; i < keyframeCount; ++i)
+        stats.keyframeBytes += keyframeAt(i).bytes;
+    return stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+#include "snapshot.hpp"
+
+#define REWIND_TICKS 600                        // Five seconds of ticks at MAX_FPS
+#define REWIND_KEYFRAME_TICKS 20                // A step back replays at most this many ticks
+#define REWIND_BUDGET_BYTES (8 * 1024 * 1024)   // For keyframes, a very long snake gets a shorter window
+#define REWIND_MAX_KEYFRAMES (REWIND_TICKS / REWIND_KEYFRAME_TICKS + 2)
+
+class Player;
+class Food;
+class TileMap;
+
+struct RewindStats
+{
+    std::uint32_t availableTicks = 0;
+    std::uint32_t keyframes = 0;
+    std::size_t keyframeBytes = 0;
+    std::uint32_t lastReplayTicks = 0; // Ticks re-simulated by the latest step back
+};
+
+// The last few seconds of a run, for stepping back one tick at a time. Every tick stores a
+// small delta: the direction the head moved in, whether it ate and the score. Every
+// REWIND_KEYFRAME_TICKS the whole snake, the food and the spawn RNG are copied into a fixed
+// byte pool, the oldest keyframe making room. A step back loads the newest keyframe before the
+// wanted tick and replays the deltas from there through the sim; the sim is deterministic, so
+// the tail, corners and food spawns come out exactly as they were. Nothing grows with the
+// length of the session.
+class RewindHistory
+{
+public:
+    // Sized for the longest snake the caller will ever record
+    explicit RewindHistory(std::size_t maxSegments);
+
+    // Tick zero of a run, after the first food has spawned
+    void start(const Player &player, const Food &food, moveDirection direction, int score);
+    void stop() { started = false; }
+    // After every tick, with the direction the tick moved in
+    void record(const Player &player, const Food &food, moveDirection direction, int score, bool ate);
+    // Puts everything back one tick, false once the window is used up
+    bool stepBack(Player &player, Food &food, const TileMap &map, moveDirection &direction, int &score);
+
+    bool isStarted() const { return started; }
+    RewindStats getStats() const;
+
+private:
+    struct Delta
+    {
+        std::int32_t score = 0;
+        moveDirection direction = moveDirection::Right;
+        bool ate = false;
+    };
+
+    struct Keyframe
+    {
+        std::uint64_t tick = 0;
+        std::size_t offset = 0;
+        std::size_t bytes = 0;
+    };
+
+    void writeKeyframe(const Player &player, const Food &food, moveDirection direction, int score);
+    void readKeyframe(const Keyframe &keyframe, Player &player, Food &food, moveDirection &direction, int &score);
+    Keyframe &keyframeAt(std::size_t index) { return keyframes[(firstKeyframe + index) % REWIND_MAX_KEYFRAMES]; }
+    const Keyframe &keyframeAt(std::size_t index) const { return keyframes[(firstKeyframe + index) % REWIND_MAX_KEYFRAMES]; }
+    void dropOldest();
+
+    std::size_t maxSegments;
+    std::vector<Delta> deltas; // Ring of REWIND_TICKS, the one at tick % REWIND_TICKS led into that tick
+    std::vector<char> pool;    // REWIND_BUDGET_BYTES of keyframes, written round like a ring
+    std::size_t poolHead = 0;
+    Keyframe keyframes[REWIND_MAX_KEYFRAMES];
+    std::size_t firstKeyframe = 0;
+    std::size_t keyframeCount = 0;
+    GameSnapshot scratch; // Reserved for the longest snake, keyframes pass through it both ways
+    std::uint64_t tick = 0;
+    std::uint32_t lastReplayTicks = 0;
+    bool started = false;
+};
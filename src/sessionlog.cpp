@@ -0,0 +1,156 @@
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include "telemetry.hpp"
+#include "sim.hpp"
+
+// Turns session logs into CSV, e.g. "sessionlog sessions.bin > players.csv"
+// or "sessionlog -s sessions.bin old/sessions.bin > sessions.csv"
+
+namespace
+{
+    struct PlayerSummary
+    {
+        std::uint64_t sessions = 0;
+        std::int64_t bestScore = 0;
+        std::int64_t totalScore = 0;
+        std::uint64_t totalDurationMs = 0;
+        std::uint64_t totalLength = 0;
+        std::uint64_t turns = 0;
+        std::uint64_t deaths[4] = {}; // Indexed by DeathCause
+        FrameHistogram frames;
+    };
+
+    const char *deathName(std::uint8_t cause)
+    {
+        switch (static_cast<DeathCause>(cause))
+        {
+        case DeathCause::Border:
+            return "border";
+        case DeathCause::Self:
+            return "self";
+        case DeathCause::Wall:
+            return "wall";
+        default:
+            return "abandoned";
+        }
+    }
+
+    std::string csvField(const std::string &text)
+    {
+        if (text.find_first_of(",\"\n") == std::string::npos)
+            return text;
+
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void printSessions(const std::vector<SessionRecord> &records)
+    {
+        std::cout << "start,username,score,duration_s,length,turns,ticks,death,autopilot,frame_p50_ms,frame_p99_ms,frame_max_bin_ms\n";
+        for (const auto &record : records)
+        {
+            char start[32];
+            std::time_t time = static_cast<std::time_t>(record.startTime);
+            std::strftime(start, sizeof(start), "%Y-%m-%d %H:%M:%S", std::localtime(&time));
+
+            std::cout << start << "," << csvField(record.username) << "," << record.score << ","
+                      << record.durationMs / 1000.0 << "," << record.length << "," << record.turns << ","
+                      << record.ticks << "," << deathName(record.deathCause) << "," << (record.autopilot ? 1 : 0) << ","
+                      << record.frames.percentile(0.5) << "," << record.frames.percentile(0.99) << ","
+                      << record.frames.percentile(1.0) << "\n";
+        }
+    }
+
+    void printPlayers(const std::vector<SessionRecord> &records)
+    {
+        std::map<std::string, PlayerSummary> players;
+        for (const auto &record : records)
+        {
+            PlayerSummary &player = players[record.username];
+            player.sessions++;
+            player.bestScore = std::max<std::int64_t>(player.bestScore, record.score);
+            player.totalScore += record.score;
+            player.totalDurationMs += record.durationMs;
+            player.totalLength += record.length;
+            player.turns += record.turns;
+            player.deaths[std::min<std::uint8_t>(record.deathCause, 3)]++;
+            player.frames.merge(record.frames);
+        }
+
+        std::cout << "username,sessions,best_score,mean_score,mean_duration_s,mean_length,turns,"
+                     "border_deaths,self_deaths,wall_deaths,abandoned,frame_p50_ms,frame_p95_ms,frame_p99_ms\n";
+        for (const auto &[name, player] : players)
+        {
+            double sessions = static_cast<double>(player.sessions);
+            std::cout << csvField(name) << "," << player.sessions << "," << player.bestScore << ","
+                      << player.totalScore / sessions << "," << player.totalDurationMs / 1000.0 / sessions << ","
+                      << player.totalLength / sessions << "," << player.turns << ","
+                      << player.deaths[static_cast<int>(DeathCause::Border)] << ","
+                      << player.deaths[static_cast<int>(DeathCause::Self)] << ","
+                      << player.deaths[static_cast<int>(DeathCause::Wall)] << ","
+                      << player.deaths[static_cast<int>(DeathCause::None)] << ","
+                      << player.frames.percentile(0.5) << "," << player.frames.percentile(0.95) << ","
+                      << player.frames.percentile(0.99) << "\n";
+        }
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: sessionlog [-s] [log ...]\n"
+                  << "  -s  one row per session instead of one per player\n"
+                  << "  log files default to " TELEMETRY_FILE "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool perSession = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-s")
+            perSession = true;
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+    if (files.empty())
+        files.push_back(TELEMETRY_FILE);
+
+    std::vector<SessionRecord> records;
+    for (const auto &file : files)
+    {
+        size_t corrupt = 0;
+        if (!readSessionLog(file, records, corrupt))
+        {
+            std::cerr << "sessionlog: " << file << " is not a session log\n";
+            return 1;
+        }
+        if (corrupt > 0)
+            std::cerr << "sessionlog: skipped " << corrupt << " damaged records in " << file << "\n";
+    }
+
+    if (perSession)
+        printSessions(records);
+    else
+        printPlayers(records);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#include "sfx.hpp"
+
+// Indexed by SoundId
+const SoundEffects::Effect SoundEffects::effects[SOUND_COUNT] = {
+    // file                 volume pitch priority cooldown voices
+    {"soundfx/pop.mp3", SFX_VOLUME, 1.0f, 1, 20, 6},         // Eat
+    {"soundfx/pop.mp3", SFX_VOLUME * 0.3f, 2.0f, 0, 80, 2},  // Turn
+    {"soundfx/pop.mp3", SFX_VOLUME * 1.6f, 0.5f, 2, 500, 1}, // Death
+};
+
+SoundEffects::SoundEffects()
+{
+    // Decoded once here, effects that use the same file share its buffer
+    buffers.reserve(SOUND_COUNT);
+    std::vector<const char *> files;
+    for (std::size_t i = 0; i < SOUND_COUNT; ++i)
+    {
+        lastPlayedUs[i] = -1;
+
+        auto found = std::find_if(files.begin(), files.end(), [&](const char *file)
+                                  { return std::strcmp(file, effects[i].file) == 0; });
+        bufferOf[i] = static_cast<std::size_t>(found - files.begin());
+        if (found != files.end())
+            continue;
+
+        files.push_back(effects[i].file);
+        buffers.emplace_back();
+        if (!buffers.back().loadFromFile(effects[i].file))
+            std::cerr << "Error loading sound file: " << effects[i].file << std::endl;
+    }
+
+    // The voices are split evenly between the buffers and stay bound to theirs
+    voices.reserve(SFX_VOICE_COUNT);
+    for (int i = 0; i < SFX_VOICE_COUNT; ++i)
+    {
+        const std::size_t buffer = static_cast<std::size_t>(i) * buffers.size() / SFX_VOICE_COUNT;
+        voices.push_back(Voice{sf::Sound(buffers[buffer]), buffer});
+    }
+}
+
+bool SoundEffects::play(SoundId id)
+{
+    const std::size_t index = static_cast<std::size_t>(id);
+    const Effect &effect = effects[index];
+    const std::int64_t now = clock.getElapsedTime().asMicroseconds();
+
+    if (lastPlayedUs[index] >= 0 && now - lastPlayedUs[index] < effect.cooldownMs * 1000)
+    {
+        stats.cooldownSkips++;
+        return false;
+    }
+
+    // One pass finds a free voice, this effect's oldest voice and the cheapest voice to steal
+    Voice *free = nullptr;
+    Voice *ownOldest = nullptr;
+    Voice *victim = nullptr;
+    int own = 0;
+    for (Voice &voice : voices)
+    {
+        if (voice.buffer != bufferOf[index])
+            continue;
+
+        if (voice.sound.getStatus() != sf::SoundSource::Status::Playing)
+        {
+            if (free == nullptr)
+                free = &voice;
+            continue;
+        }
+
+        if (voice.id == id)
+        {
+            own++;
+            if (ownOldest == nullptr || voice.startedUs < ownOldest->startedUs)
+                ownOldest = &voice;
+        }
+
+        // Lowest priority first, the oldest of those
+        if (voice.priority <= effect.priority &&
+            (victim == nullptr || voice.priority < victim->priority ||
+             (voice.priority == victim->priority && voice.startedUs < victim->startedUs)))
+            victim = &voice;
+    }
+
+    Voice *chosen = nullptr;
+    if (own >= effect.maxVoices)
+    {
+        chosen = ownOldest;
+        stats.steals++;
+    }
+    else if (free != nullptr)
+    {
+        chosen = free;
+    }
+    else if (victim != nullptr)
+    {
+        chosen = victim;
+        stats.steals++;
+    }
+    else
+    {
+        stats.drops++;
+        return false;
+    }
+
+    // Only volume and pitch change, the voice already plays this effect's buffer
+    chosen->sound.stop();
+    chosen->sound.setVolume(effect.volume);
+    chosen->sound.setPitch(effect.pitch);
+    chosen->sound.play();
+    chosen->id = id;
+    chosen->priority = effect.priority;
+    chosen->startedUs = now;
+
+    lastPlayedUs[index] = now;
+    stats.plays++;
+    return true;
+}
+
+void SoundEffects::stopAll()
+{
+    for (Voice &voice : voices)
+        voice.sound.stop();
+}
+
+void SoundEffects::update()
+{
+    std::uint32_t active = 0;
+    for (const Voice &voice : voices)
+        if (voice.sound.getStatus() == sf::SoundSource::Status::Playing)
+            active++;
+
+    stats.activeVoices = active;
+    stats.peakVoices = std::max(stats.peakVoices, active);
+}
+
+std::uint64_t SoundEffects::getBufferBytes() const
+{
+    std::uint64_t bytes = 0;
+    for (const auto &buffer : buffers)
+        bytes += buffer.getSampleCount() * sizeof(std::int16_t);
+    return bytes;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <vector>
+#include <cstdint>
+
+#define SFX_VOICE_COUNT 16 // Sounds that can play at once
+#define SFX_VOLUME 50.0f
+
+enum class SoundId
+{
+    Eat,
+    Turn,
+    Death,
+    Count
+};
+
+constexpr std::size_t SOUND_COUNT = static_cast<std::size_t>(SoundId::Count);
+
+struct SfxStats
+{
+    std::uint64_t plays = 0;
+    std::uint64_t steals = 0;        // A playing voice was cut off for this one
+    std::uint64_t drops = 0;         // Every voice was busy with something more important
+    std::uint64_t cooldownSkips = 0; // Asked for again too soon after the last one
+    std::uint32_t activeVoices = 0;
+    std::uint32_t peakVoices = 0;
+};
+
+// Fixed pool of voices over buffers decoded at startup. Every voice is bound to its buffer once,
+// as rebinding allocates inside SFML. play() picks a free voice of the effect's buffer, or steals
+// the least important one, so it never allocates and rapid repeats overlap instead of cutting off.
+class SoundEffects
+{
+public:
+    SoundEffects();
+
+    SoundEffects(const SoundEffects &) = delete;
+    SoundEffects &operator=(const SoundEffects &) = delete;
+
+    bool play(SoundId id); // False if skipped or dropped
+    void stopAll();
+    void update(); // Once per frame, refreshes the voice counts
+
+    const SfxStats &getStats() const { return stats; }
+    std::uint64_t getBufferBytes() const;
+
+private:
+    struct Effect
+    {
+        const char *file;
+        float volume;
+        float pitch;
+        int priority;            // Higher steals from lower
+        std::int32_t cooldownMs; // Minimum time between two plays
+        int maxVoices;           // Further plays restart the oldest of its own voices
+    };
+
+    struct Voice
+    {
+        sf::Sound sound;
+        std::size_t buffer = 0; // Fixed at construction
+        SoundId id = SoundId::Count;
+        int priority = 0;
+        std::int64_t startedUs = 0;
+    };
+
+    static const Effect effects[SOUND_COUNT];
+
+    std::vector<sf::SoundBuffer> buffers; // One per distinct file, never resized once voices point at them
+    std::size_t bufferOf[SOUND_COUNT];
+    std::vector<Voice> voices;
+    std::int64_t lastPlayedUs[SOUND_COUNT];
+    sf::Clock clock;
+    SfxStats stats;
+};
@@ -0,0 +1,199 @@
+#include "sharedmemory.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    std::string systemName(const std::string &name)
+    {
+#ifdef _WIN32
+        return "Local\\" + name;
+#else
+        return "/" + name;
+#endif
+    }
+
+    void *mapSegment(const std::string &path, std::size_t size, bool create, bool writable, void *&handle)
+    {
+#ifdef _WIN32
+        HANDLE mapping = create
+                             ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), path.c_str())
+                             : OpenFileMappingA(writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, FALSE, path.c_str());
+        if (mapping == nullptr)
+            return nullptr;
+
+        void *view = MapViewOfFile(mapping, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+        if (view == nullptr)
+        {
+            CloseHandle(mapping);
+            return nullptr;
+        }
+        handle = mapping;
+        return view;
+#else
+        int fd = create ? shm_open(path.c_str(), O_CREAT | O_RDWR, 0644)
+                        : shm_open(path.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0)
+            return nullptr;
+
+        if (create && ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        void *view = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED)
+            return nullptr;
+        handle = nullptr;
+        return view;
+#endif
+    }
+}
+
+SharedMemory::~SharedMemory()
+{
+    close();
+}
+
+bool SharedMemory::create(const std::string &name, std::size_t size)
+{
+    close();
+    path = systemName(name);
+    view = mapSegment(path, size, true, true, handle);
+    if (view == nullptr)
+        return false;
+
+    bytes = size;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::open(const std::string &name, std::size_t size, bool writable)
+{
+    close();
+    path = systemName(name);
+    view = mapSegment(path, size, false, writable, handle);
+    if (view == nullptr)
+        return false;
+
+    bytes = size;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (view == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(static_cast<HANDLE>(handle));
+#else
+    munmap(view, bytes);
+    if (owner)
+        shm_unlink(path.c_str());
+#endif
+
+    view = nullptr;
+    handle = nullptr;
+    bytes = 0;
+    owner = false;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &filename, std::size_t size)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                    OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    // Mapping past the end grows the file, zero filled
+    const ULONGLONG wanted = size;
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(wanted >> 32),
+                                              static_cast<DWORD>(wanted), nullptr);
+    if (mappingHandle == nullptr)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    view = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+    file = fileHandle;
+    mapping = mappingHandle;
+#else
+    int fd = ::open(filename.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (static_cast<std::size_t>(info.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    view = mapped;
+#endif
+
+    bytes = size;
+    return true;
+}
+
+void MappedFile::flush()
+{
+    if (view == nullptr)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(view, bytes);
+#else
+    msync(view, bytes, MS_ASYNC);
+#endif
+}
+
+void MappedFile::close()
+{
+    if (view == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    CloseHandle(static_cast<HANDLE>(file));
+#else
+    munmap(view, bytes);
+#endif
+
+    view = nullptr;
+    file = nullptr;
+    mapping = nullptr;
+    bytes = 0;
+}
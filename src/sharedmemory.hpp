@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Named shared memory segment, POSIX shm or a Windows pagefile mapping.
+// The creator owns the name and removes it again when it goes away.
+class SharedMemory
+{
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+
+    // Create (or take over) the segment, zero filled on first creation
+    bool create(const std::string &name, std::size_t size);
+    // Map an existing segment made by someone else
+    bool open(const std::string &name, std::size_t size, bool writable);
+    void close();
+
+    bool isOpen() const { return view != nullptr; }
+    void *data() const { return view; }
+    std::size_t size() const { return bytes; }
+
+private:
+    void *view = nullptr;
+    void *handle = nullptr;
+    std::size_t bytes = 0;
+    bool owner = false;
+    std::string path;
+};
+
+// A file on disk mapped read/write, grown to the requested size. Writes reach the file
+// through the page cache, flush() only asks for them to be written out sooner.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Creates the file if needed, new bytes read as zero
+    bool open(const std::string &filename, std::size_t size);
+    void flush();
+    void close();
+
+    bool isOpen() const { return view != nullptr; }
+    void *data() const { return view; }
+    std::size_t size() const { return bytes; }
+
+private:
+    void *view = nullptr;
+    void *file = nullptr;
+    void *mapping = nullptr;
+    std::size_t bytes = 0;
+};
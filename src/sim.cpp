@@ -0,0 +1,43 @@
+#include "sim.hpp"
+#include "player.hpp"
+#include "tilemap.hpp"
+
+TickResult checkTick(Player &player, Food &food, const TileMap &map)
+{
+    TickResult result;
+
+    // Everything is tested along the whole move since last tick and whatever the head reaches
+    // first wins, as if the tick had been split into single steps. Ties die in this order.
+    SimCoord deathAt = -1;
+    auto die = [&](SimCoord distance, DeathCause cause)
+    {
+        if (distance >= 0 && (deathAt < 0 || distance < deathAt))
+        {
+            deathAt = distance;
+            result.death = cause;
+        }
+    };
+    die(player.borderHit(), DeathCause::Border);
+    die(player.wallHit(map), DeathCause::Wall);
+    die(player.selfHit(), DeathCause::Self);
+
+    // Food reached before the fatal step still counts
+    SimCoord foodAt = player.foodHit(food);
+    if (foodAt >= 0 && (deathAt < 0 || foodAt < deathAt))
+    {
+        player.spawnTail();
+        food.spawn(player, map);
+        result.ate = true;
+    }
+
+    return result;
+}
+
+void advanceTick(Player &player, moveDirection direction, JobSystem *jobs)
+{
+    player.moveSnake(direction);
+    player.incrementFramesSinceTurn();
+    player.storePosition();
+    player.updateTail(jobs);
+    player.updateCorners();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "types.hpp"
+
+class Player;
+class Food;
+class TileMap;
+class JobSystem;
+
+enum class DeathCause
+{
+    None,
+    Border,
+    Self,
+    Wall
+};
+
+struct TickResult
+{
+    DeathCause death = DeathCause::None;
+    bool ate = false; // Can come with a death when the food was reached first
+};
+
+// One PLAYING tick, split where the game reads input in between.
+// Shared by the game loop and every headless driver so they all run the same rules.
+
+// Start of a tick: die or eat anywhere along the last move
+TickResult checkTick(Player &player, Food &food, const TileMap &map);
+// End of a tick: move one step and let the tail and corners follow, the tail on the workers if given
+void advanceTick(Player &player, moveDirection direction, JobSystem *jobs = nullptr);
@@ -0,0 +1,179 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstdlib>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "snapshot.hpp"
+#include "tilemap.hpp"
+
+// Checks the swept collision tests against a brute force reference, e.g. "simcheck -n 20000".
+// Every random move is walked one sim unit at a time with plain box tests, and the first
+// distance each test reports has to match the first unit where the reference touches
+// something. Needs MAP_FILE, so it runs from the folder the game runs in.
+
+namespace
+{
+    constexpr int tailSegments = 40;
+    constexpr float scatter = 300.0f; // Pixels around the start the tail and food are placed in
+
+    enum Check
+    {
+        Border,
+        Wall,
+        Self,
+        FoodHit,
+        CheckCount
+    };
+    const char *checkNames[CheckCount] = {"border", "wall", "self", "food"};
+
+    void printUsage()
+    {
+        std::cerr << "usage: simcheck [-n moves] [-s seed]\n"
+                  << "  -n  random moves to compare (default 20000)\n"
+                  << "  -s  seed of the moves (default 1)\n";
+    }
+
+    struct Move
+    {
+        GameSnapshot state;
+        SimVector start;
+        SimVector step; // One sim unit along the move
+        SimCoord length = 0;
+        SimVector food;
+    };
+
+    Move randomMove(std::mt19937 &gen)
+    {
+        const SimCoord width = toSim(WORLD_WIDTH);
+        const SimCoord height = toSim(WORLD_HEIGHT);
+        std::uniform_int_distribution<SimCoord> startX(0, width - 1);
+        std::uniform_int_distribution<SimCoord> startY(0, height - 1);
+        std::uniform_int_distribution<SimCoord> length(0, toSim(200));
+        std::uniform_int_distribution<SimCoord> near(-toSim(scatter), toSim(scatter));
+        std::uniform_int_distribution<int> segments(0, tailSegments);
+
+        Move move;
+        move.start = {startX(gen), startY(gen)};
+        // A third start on the segment grid, where tails line up with the head
+        if (gen() % 3 == 0)
+            move.start.x = move.start.x / toSim(PLAYER_SIZE) * toSim(PLAYER_SIZE);
+
+        const SimVector steps[4] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+        move.step = steps[gen() % 4];
+        move.length = length(gen);
+        const SimVector end{move.start.x + move.step.x * move.length, move.start.y + move.step.y * move.length};
+
+        move.state.headPosition = end;
+        move.state.positionHistory = {end, move.start};
+        for (int i = segments(gen); i > 0; --i)
+            move.state.tail.push_back({{move.start.x + near(gen), move.start.y + near(gen)}, 0, gen() % 5 == 0});
+        move.food = {move.start.x + near(gen), move.start.y + near(gen)};
+        return move;
+    }
+
+    // First unit along the move where each test touches something, -1 where nothing is
+    void reference(const Move &move, const TileMap &map, SimCoord first[CheckCount])
+    {
+        const SimCoord half = toSim(PLAYER_SIZE / 2);
+        const SimCoord body = toSim(PLAYER_SIZE);
+        const SimCoord foodReach = toSim((PLAYER_SIZE + FOOD_SIZE) / 2);
+        const SimVector limit{toSim(WORLD_WIDTH), toSim(WORLD_HEIGHT)};
+        const std::vector<TailState> &tail = move.state.tail;
+
+        for (int check = 0; check < CheckCount; ++check)
+            first[check] = -1;
+
+        for (SimCoord distance = 0; distance <= move.length; ++distance)
+        {
+            const SimVector head{move.start.x + move.step.x * distance, move.start.y + move.step.y * distance};
+
+            if (first[Border] < 0 && (head.x - half < 0 || head.x + half > limit.x || head.y - half < 0 || head.y + half > limit.y))
+                first[Border] = distance;
+            if (first[Wall] < 0 && map.overlapsWall(head, half))
+                first[Wall] = distance;
+            // The two segments behind the head never count, nor frozen ones or a tail shorter than three
+            for (size_t i = 2; first[Self] < 0 && tail.size() >= 3 && i < tail.size(); ++i)
+            {
+                if (!tail[i].isFrozen && std::abs(tail[i].position.x - head.x) < body && std::abs(tail[i].position.y - head.y) < body)
+                    first[Self] = distance;
+            }
+            if (first[FoodHit] < 0 && std::abs(move.food.x - head.x) < foodReach && std::abs(move.food.y - head.y) < foodReach)
+                first[FoodHit] = distance;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int moves = 20000;
+    std::uint32_t seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            moves = std::stoi(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    TileMap map(MAP_COLUMNS, MAP_ROWS);
+    if (!map.loadFromFile(MAP_FILE))
+    {
+        std::cerr << "simcheck: could not load " MAP_FILE ", run it from the folder the game runs in\n";
+        return 1;
+    }
+
+    std::mt19937 gen(seed);
+    int mismatches[CheckCount] = {};
+    int hits[CheckCount] = {};
+    int sweepMismatches = 0;
+
+    for (int n = 0; n < moves; ++n)
+    {
+        const Move move = randomMove(gen);
+        Player player;
+        player.loadState(move.state);
+        Food food;
+        food.setSimPosition(move.food);
+
+        // The sweep has to cover the whole move, not just one axis of it
+        const SimSweep sweep = player.getSweep();
+        if (sweep.start != move.start || sweep.at(sweep.length) != move.state.headPosition)
+            sweepMismatches++;
+
+        SimCoord expected[CheckCount];
+        reference(move, map, expected);
+        const SimCoord got[CheckCount] = {player.borderHit(), player.wallHit(map), player.selfHit(), player.foodHit(food)};
+
+        for (int check = 0; check < CheckCount; ++check)
+        {
+            if (expected[check] >= 0)
+                hits[check]++;
+            if (got[check] == expected[check])
+                continue;
+            if (mismatches[check] < 3)
+                std::cerr << "simcheck: move " << n << " " << checkNames[check] << " at " << got[check]
+                          << ", the reference says " << expected[check] << "\n";
+            mismatches[check]++;
+        }
+    }
+
+    int total = sweepMismatches;
+    for (int check = 0; check < CheckCount; ++check)
+    {
+        std::cout << checkNames[check] << ": " << hits[check] << " hits, " << mismatches[check] << " mismatches\n";
+        total += mismatches[check];
+    }
+    if (sweepMismatches > 0)
+        std::cout << sweepMismatches << " sweeps didn't follow the move\n";
+
+    return total == 0 ? 0 : 1;
+}
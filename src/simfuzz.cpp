@@ -0,0 +1,586 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "game.hpp"
+#include "player.hpp"
+#include "input.hpp"
+#include "sim.hpp"
+#include "tilemap.hpp"
+
+// Searches for the input sequences that make single ticks of the headless sim slowest, e.g.
+// "simfuzz -t 120 -o fuzzcases". Scenarios are mutated from the slowest ones found so far and
+// the slowest per phase are written out as text files; "simfuzz -r fuzzcases/*.scn -m 500"
+// replays them later and fails when a tick takes longer than the given microseconds.
+
+namespace
+{
+    constexpr int corpusSize = 8;         // Scenarios kept per phase
+    constexpr int confirmRuns = 3;        // A tick's cost is the fastest of this many replays, the rest is noise
+    constexpr std::uint32_t maxTicks = 6000;
+    constexpr std::uint32_t maxInputs = 400;
+    constexpr std::uint32_t maxGrow = 400; // Segments added by one grow input
+
+    enum class Phase
+    {
+        Collision, // checkTick without eating: the sweeps against the body, border and walls
+        Spawn,     // checkTick that ate, or an eat input: mostly Food::spawn
+        Advance,   // advanceTick: head, tail, corners
+        Count
+    };
+    const char *phaseNames[] = {"collision", "spawn", "advance"};
+    constexpr int phaseCount = static_cast<int>(Phase::Count);
+
+    enum class InputKind
+    {
+        Turn, // Through the TurnQueue, so the usual turn spacing applies
+        Grow, // Adds segments at the head, like eating that many times without the spawns
+        Eat   // Adds one segment and respawns the food, exactly what eating does
+    };
+
+    struct FuzzInput
+    {
+        std::uint32_t tick = 0;
+        InputKind kind = InputKind::Turn;
+        moveDirection direction = moveDirection::Up;
+        std::uint32_t count = 1;
+    };
+
+    struct Scenario
+    {
+        std::uint32_t seed = 1;
+        std::uint32_t ticks = 1000;
+        std::vector<FuzzInput> inputs; // Sorted by tick
+    };
+
+    struct Measurement
+    {
+        std::int64_t worstNs[phaseCount] = {};
+        std::uint32_t worstTick[phaseCount] = {};
+        std::uint32_t ticksRun = 0;
+        DeathCause death = DeathCause::None;
+        size_t length = 0;
+    };
+
+    struct CorpusEntry
+    {
+        Scenario scenario;
+        Measurement measurement;
+    };
+
+    const char *directionNames[] = {"up", "down", "left", "right"};
+
+    void printUsage()
+    {
+        std::cerr << "usage: simfuzz [-t seconds] [-s seed] [-o dir]\n"
+                  << "       simfuzz -r scenario ... [-m max_us]\n"
+                  << "  -t  how long to search (default 60)\n"
+                  << "  -s  seed of the search itself (default 1)\n"
+                  << "  -o  where the slowest scenarios are written (default fuzzcases)\n"
+                  << "  -r  replay scenarios instead of searching\n"
+                  << "  -m  fail when a replayed tick takes longer than this (default no limit)\n";
+    }
+
+    std::int64_t elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    }
+
+    void charge(Measurement &measurement, Phase phase, std::int64_t ns, std::uint32_t tick)
+    {
+        const int index = static_cast<int>(phase);
+        if (ns > measurement.worstNs[index])
+        {
+            measurement.worstNs[index] = ns;
+            measurement.worstTick[index] = tick;
+        }
+    }
+
+    // Runs the scenario the way the agent server does and times every tick. Per-tick costs
+    // are written to costs[phase][tick] so several runs can be combined.
+    Measurement replay(const Scenario &scenario, const TileMap &map, std::vector<std::int64_t> costs[phaseCount])
+    {
+        Player player;
+        Food food;
+        TurnQueue turns;
+        moveDirection direction = moveDirection::Right;
+        player.reserve(MAX_SNAKE_SEGMENTS);
+        food.rng.reseed(scenario.seed);
+        food.spawn(player, map);
+
+        for (int phase = 0; phase < phaseCount; ++phase)
+            costs[phase].assign(scenario.ticks, 0);
+
+        Measurement measurement;
+        size_t next = 0;
+        for (std::uint32_t tick = 0; tick < scenario.ticks; ++tick)
+        {
+            for (; next < scenario.inputs.size() && scenario.inputs[next].tick == tick; ++next)
+            {
+                const FuzzInput &input = scenario.inputs[next];
+                if (input.kind == InputKind::Turn)
+                {
+                    turns.push(input.direction, direction, sf::Time::Zero);
+                }
+                else if (input.kind == InputKind::Grow)
+                {
+                    // No longer than the game makes room for, a snake in every cell of the world
+                    for (std::uint32_t i = 0; i < input.count && player.tailSegments.size() < MAX_SNAKE_SEGMENTS; ++i)
+                        player.spawnTail();
+                }
+                else if (player.tailSegments.size() < MAX_SNAKE_SEGMENTS)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    player.spawnTail();
+                    food.spawn(player, map);
+                    costs[static_cast<int>(Phase::Spawn)][tick] += elapsedNs(start, std::chrono::steady_clock::now());
+                }
+            }
+
+            PendingTurn turn;
+            if (turns.popReady(direction, player.framesSinceTurn, 2 * framesPerSegment, turn))
+                direction = turn.direction;
+
+            auto start = std::chrono::steady_clock::now();
+            advanceTick(player, direction);
+            auto advanced = std::chrono::steady_clock::now();
+            TickResult result = checkTick(player, food, map);
+            auto checked = std::chrono::steady_clock::now();
+
+            costs[static_cast<int>(Phase::Advance)][tick] += elapsedNs(start, advanced);
+            costs[static_cast<int>(result.ate ? Phase::Spawn : Phase::Collision)][tick] += elapsedNs(advanced, checked);
+            measurement.ticksRun = tick + 1;
+
+            if (result.death != DeathCause::None)
+            {
+                measurement.death = result.death;
+                break;
+            }
+        }
+
+        measurement.length = player.tailSegments.size();
+        for (int phase = 0; phase < phaseCount; ++phase)
+            for (std::uint32_t tick = 0; tick < measurement.ticksRun; ++tick)
+                charge(measurement, static_cast<Phase>(phase), costs[phase][tick], tick);
+        return measurement;
+    }
+
+    // Worst ticks from the fastest of several runs, so one preempted tick doesn't count
+    Measurement measure(const Scenario &scenario, const TileMap &map, int runs)
+    {
+        std::vector<std::int64_t> costs[phaseCount];
+        std::vector<std::int64_t> fastest[phaseCount];
+        Measurement measurement = replay(scenario, map, fastest);
+        for (int run = 1; run < runs; ++run)
+        {
+            replay(scenario, map, costs);
+            for (int phase = 0; phase < phaseCount; ++phase)
+                for (std::uint32_t tick = 0; tick < measurement.ticksRun; ++tick)
+                    fastest[phase][tick] = std::min(fastest[phase][tick], costs[phase][tick]);
+        }
+
+        for (int phase = 0; phase < phaseCount; ++phase)
+        {
+            measurement.worstNs[phase] = 0;
+            for (std::uint32_t tick = 0; tick < measurement.ticksRun; ++tick)
+                charge(measurement, static_cast<Phase>(phase), fastest[phase][tick], tick);
+        }
+        return measurement;
+    }
+
+    void sortInputs(Scenario &scenario)
+    {
+        std::stable_sort(scenario.inputs.begin(), scenario.inputs.end(),
+                         [](const FuzzInput &a, const FuzzInput &b)
+                         { return a.tick < b.tick; });
+    }
+
+    FuzzInput randomInput(std::mt19937 &gen, std::uint32_t ticks)
+    {
+        FuzzInput input;
+        input.tick = std::uniform_int_distribution<std::uint32_t>(0, ticks - 1)(gen);
+        const int roll = std::uniform_int_distribution<int>(0, 9)(gen);
+        input.kind = roll < 7 ? InputKind::Turn : roll < 9 ? InputKind::Eat : InputKind::Grow;
+        input.direction = static_cast<moveDirection>(std::uniform_int_distribution<int>(0, 3)(gen));
+        if (input.kind == InputKind::Grow)
+            input.count = std::uniform_int_distribution<std::uint32_t>(1, maxGrow)(gen);
+        return input;
+    }
+
+    Scenario randomScenario(std::mt19937 &gen)
+    {
+        Scenario scenario;
+        scenario.seed = gen();
+        scenario.ticks = std::uniform_int_distribution<std::uint32_t>(500, maxTicks)(gen);
+        const std::uint32_t inputs = std::uniform_int_distribution<std::uint32_t>(4, 40)(gen);
+        for (std::uint32_t i = 0; i < inputs; ++i)
+            scenario.inputs.push_back(randomInput(gen, scenario.ticks));
+        sortInputs(scenario);
+        return scenario;
+    }
+
+    // One or a few random edits. The death tick of the parent is passed in so a run that
+    // ended early can be steered past whatever killed it.
+    Scenario mutate(const Scenario &parent, const Scenario &other, std::uint32_t deathTick, std::mt19937 &gen)
+    {
+        Scenario scenario = parent;
+        auto pick = [&](std::uint32_t bound)
+        { return std::uniform_int_distribution<std::uint32_t>(0, bound - 1)(gen); };
+
+        const std::uint32_t edits = 1 + pick(3);
+        for (std::uint32_t edit = 0; edit < edits; ++edit)
+        {
+            switch (pick(9))
+            {
+            case 0: // Another food sequence
+                scenario.seed = gen();
+                break;
+            case 1: // More or fewer ticks
+                scenario.ticks = std::clamp<std::uint32_t>(scenario.ticks / 2 + pick(scenario.ticks + 1), 100, maxTicks);
+                break;
+            case 2:
+                scenario.inputs.push_back(randomInput(gen, scenario.ticks));
+                break;
+            case 3: // A burst of turns, one corner after another as fast as the queue allows
+            {
+                const std::uint32_t start = pick(scenario.ticks);
+                const std::uint32_t turnsInBurst = 2 + pick(16);
+                moveDirection direction = static_cast<moveDirection>(pick(4));
+                for (std::uint32_t i = 0; i < turnsInBurst; ++i)
+                {
+                    const bool vertical = direction == moveDirection::Up || direction == moveDirection::Down;
+                    if (vertical)
+                        direction = pick(2) ? moveDirection::Left : moveDirection::Right;
+                    else
+                        direction = pick(2) ? moveDirection::Up : moveDirection::Down;
+                    scenario.inputs.push_back({start + i * 2 * framesPerSegment, InputKind::Turn, direction, 1});
+                }
+                break;
+            }
+            case 4:
+                if (!scenario.inputs.empty())
+                    scenario.inputs.erase(scenario.inputs.begin() + pick(static_cast<std::uint32_t>(scenario.inputs.size())));
+                break;
+            case 5: // Nudge an input a few ticks either way
+                if (!scenario.inputs.empty())
+                {
+                    FuzzInput &input = scenario.inputs[pick(static_cast<std::uint32_t>(scenario.inputs.size()))];
+                    input.tick = std::min(input.tick + pick(61) - std::min<std::uint32_t>(input.tick, 30), scenario.ticks - 1);
+                }
+                break;
+            case 6: // Splice: this scenario's inputs up to a tick, the other's after it
+            {
+                const std::uint32_t cut = pick(scenario.ticks);
+                scenario.inputs.erase(std::remove_if(scenario.inputs.begin(), scenario.inputs.end(),
+                                                     [cut](const FuzzInput &input)
+                                                     { return input.tick >= cut; }),
+                                      scenario.inputs.end());
+                for (const FuzzInput &input : other.inputs)
+                    if (input.tick >= cut)
+                        scenario.inputs.push_back(input);
+                break;
+            }
+            case 7: // Turn away just before the death, both ways round
+                if (deathTick > 0 && deathTick < scenario.ticks)
+                {
+                    const std::uint32_t before = std::min<std::uint32_t>(deathTick, 1 + pick(3 * framesPerSegment));
+                    scenario.inputs.push_back({deathTick - before, InputKind::Turn, static_cast<moveDirection>(pick(4)), 1});
+                }
+                break;
+            default: // Feed the snake where it already is long
+            {
+                const std::uint32_t tick = pick(scenario.ticks);
+                const std::uint32_t meals = 1 + pick(8);
+                for (std::uint32_t i = 0; i < meals; ++i)
+                    scenario.inputs.push_back({std::min(tick + i * framesPerSegment, scenario.ticks - 1), InputKind::Eat, moveDirection::Up, 1});
+                break;
+            }
+            }
+        }
+
+        for (FuzzInput &input : scenario.inputs)
+            input.tick = std::min(input.tick, scenario.ticks - 1);
+        sortInputs(scenario);
+        if (scenario.inputs.size() > maxInputs)
+            scenario.inputs.resize(maxInputs);
+        return scenario;
+    }
+
+    // Slowest first, no more than corpusSize. False if the entry didn't make it.
+    bool offer(std::vector<CorpusEntry> &corpus, int phase, const CorpusEntry &entry)
+    {
+        if (corpus.size() == corpusSize && entry.measurement.worstNs[phase] <= corpus.back().measurement.worstNs[phase])
+            return false;
+
+        auto slower = [phase](const CorpusEntry &a, const CorpusEntry &b)
+        { return a.measurement.worstNs[phase] > b.measurement.worstNs[phase]; };
+        corpus.insert(std::upper_bound(corpus.begin(), corpus.end(), entry, slower), entry);
+        if (corpus.size() > corpusSize)
+            corpus.pop_back();
+        return true;
+    }
+
+    std::string describe(const Measurement &measurement, int phase)
+    {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << measurement.worstNs[phase] / 1000.0 << " us at tick "
+             << measurement.worstTick[phase];
+        return text.str();
+    }
+
+    void writeScenario(std::ostream &out, const Scenario &scenario)
+    {
+        out << "seed " << scenario.seed << '\n'
+            << "ticks " << scenario.ticks << '\n';
+        for (const FuzzInput &input : scenario.inputs)
+        {
+            if (input.kind == InputKind::Turn)
+                out << "turn " << input.tick << ' ' << directionNames[static_cast<int>(input.direction)] << '\n';
+            else if (input.kind == InputKind::Grow)
+                out << "grow " << input.tick << ' ' << input.count << '\n';
+            else
+                out << "eat " << input.tick << '\n';
+        }
+    }
+
+    bool readScenario(const std::string &filename, Scenario &scenario)
+    {
+        std::ifstream in(filename);
+        if (!in)
+            return false;
+
+        scenario = Scenario();
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream words(line);
+            std::string word;
+            if (!(words >> word) || word[0] == '#')
+                continue;
+
+            FuzzInput input;
+            if (word == "seed")
+            {
+                words >> scenario.seed;
+                continue;
+            }
+            if (word == "ticks")
+            {
+                words >> scenario.ticks;
+                continue;
+            }
+            if (word == "turn")
+            {
+                std::string name;
+                words >> input.tick >> name;
+                auto found = std::find(std::begin(directionNames), std::end(directionNames), name);
+                if (found == std::end(directionNames))
+                    return false;
+                input.direction = static_cast<moveDirection>(found - std::begin(directionNames));
+            }
+            else if (word == "grow")
+            {
+                input.kind = InputKind::Grow;
+                words >> input.tick >> input.count;
+            }
+            else if (word == "eat")
+            {
+                input.kind = InputKind::Eat;
+                words >> input.tick;
+            }
+            else
+            {
+                return false;
+            }
+
+            if (!words)
+                return false;
+            scenario.inputs.push_back(input);
+        }
+
+        if (scenario.ticks == 0 || scenario.ticks > maxTicks)
+            return false;
+        sortInputs(scenario);
+        return true;
+    }
+
+    bool writeCorpus(const std::string &directory, const std::vector<CorpusEntry> corpus[phaseCount])
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        for (int phase = 0; phase < phaseCount; ++phase)
+        {
+            for (size_t rank = 0; rank < corpus[phase].size(); ++rank)
+            {
+                const CorpusEntry &entry = corpus[phase][rank];
+                std::ofstream out(directory + "/" + phaseNames[phase] + "_" + std::to_string(rank) + ".scn");
+                if (!out)
+                    return false;
+
+                out << "# slowest " << phaseNames[phase] << " tick " << describe(entry.measurement, phase)
+                    << ", " << entry.measurement.length << " segments at the end\n";
+                writeScenario(out, entry.scenario);
+            }
+        }
+        return true;
+    }
+
+    int runSearch(double seconds, std::uint32_t seed, const std::string &directory, const TileMap &map)
+    {
+        std::mt19937 gen(seed);
+        std::vector<CorpusEntry> corpus[phaseCount];
+
+        auto consider = [&](const Scenario &scenario)
+        {
+            // Cheap single run first, only a likely improvement is worth confirming
+            std::vector<std::int64_t> costs[phaseCount];
+            const Measurement screened = replay(scenario, map, costs);
+            bool promising = false;
+            for (int phase = 0; phase < phaseCount; ++phase)
+                promising |= corpus[phase].size() < corpusSize || screened.worstNs[phase] > corpus[phase].back().measurement.worstNs[phase];
+            if (!promising)
+                return 0;
+
+            const CorpusEntry entry{scenario, measure(scenario, map, confirmRuns)};
+            int improved = 0;
+            for (int phase = 0; phase < phaseCount; ++phase)
+                improved += offer(corpus[phase], phase, entry) ? 1 : 0;
+            return improved;
+        };
+
+        for (int i = 0; i < corpusSize; ++i)
+            consider(randomScenario(gen));
+
+        const auto start = std::chrono::steady_clock::now();
+        auto lastReport = start;
+        std::uint64_t tried = 0;
+        std::uint64_t kept = 0;
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+        {
+            // Parents lean towards the slowest of a random phase, min of two draws favours low ranks
+            const int phase = std::uniform_int_distribution<int>(0, phaseCount - 1)(gen);
+            const std::vector<CorpusEntry> &pool = corpus[phase];
+            std::uniform_int_distribution<size_t> rank(0, pool.size() - 1);
+            const CorpusEntry &parent = pool[std::min(rank(gen), rank(gen))];
+            const CorpusEntry &other = pool[rank(gen)];
+
+            const std::uint32_t deathTick = parent.measurement.death != DeathCause::None ? parent.measurement.ticksRun : 0;
+            kept += consider(mutate(parent.scenario, other.scenario, deathTick, gen)) > 0 ? 1 : 0;
+            tried++;
+
+            auto now = std::chrono::steady_clock::now();
+            if (std::chrono::duration<double>(now - lastReport).count() >= 5.0)
+            {
+                lastReport = now;
+                std::cout << std::fixed << std::setprecision(0) << std::chrono::duration<double>(now - start).count() << " s, "
+                          << tried << " tried, " << kept << " kept";
+                for (int p = 0; p < phaseCount; ++p)
+                    std::cout << ", " << phaseNames[p] << " " << describe(corpus[p].front().measurement, p);
+                std::cout << std::endl;
+            }
+        }
+
+        if (!writeCorpus(directory, corpus))
+        {
+            std::cerr << "simfuzz: could not write to " << directory << "\n";
+            return 1;
+        }
+
+        std::cout << tried << " scenarios tried, the slowest written to " << directory << "\n";
+        for (int phase = 0; phase < phaseCount; ++phase)
+            std::cout << "  " << std::setw(10) << std::left << phaseNames[phase] << std::right
+                      << describe(corpus[phase].front().measurement, phase) << "\n";
+        return 0;
+    }
+
+    int runReplay(const std::vector<std::string> &files, double maxMicroseconds, const TileMap &map)
+    {
+        int failed = 0;
+        for (const std::string &file : files)
+        {
+            Scenario scenario;
+            if (!readScenario(file, scenario))
+            {
+                std::cerr << "simfuzz: " << file << " is not a scenario\n";
+                return 1;
+            }
+
+            const Measurement measurement = measure(scenario, map, confirmRuns);
+            bool over = false;
+            std::cout << file << ":";
+            for (int phase = 0; phase < phaseCount; ++phase)
+            {
+                std::cout << " " << phaseNames[phase] << " " << describe(measurement, phase) << ";";
+                over |= maxMicroseconds > 0 && measurement.worstNs[phase] > maxMicroseconds * 1000.0;
+            }
+            std::cout << " " << measurement.ticksRun << " ticks" << (over ? "  OVER BUDGET" : "") << "\n";
+            failed += over ? 1 : 0;
+        }
+
+        if (failed > 0)
+        {
+            std::cerr << "simfuzz: " << failed << " of " << files.size() << " scenarios over " << maxMicroseconds << " us\n";
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = 60.0;
+    std::uint32_t seed = 1;
+    std::string directory = "fuzzcases";
+    double maxMicroseconds = 0.0;
+    bool replaying = false;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc)
+            seconds = std::stod(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "-o" && i + 1 < argc)
+            directory = argv[++i];
+        else if (arg == "-m" && i + 1 < argc)
+            maxMicroseconds = std::stod(argv[++i]);
+        else if (arg == "-r")
+            replaying = true;
+        else if (replaying && !arg.empty() && arg[0] != '-')
+            files.push_back(arg);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    // The shipped walls, like the game and the agent server
+    TileMap map(MAP_COLUMNS, MAP_ROWS);
+    if (!map.loadFromFile(MAP_FILE))
+    {
+        std::cerr << "simfuzz: could not load " MAP_FILE ", run it from the folder the game runs in\n";
+        return 1;
+    }
+
+    if (replaying)
+    {
+        if (files.empty())
+        {
+            printUsage();
+            return 1;
+        }
+        return runReplay(files, maxMicroseconds, map);
+    }
+    return runSearch(seconds, seed, directory, map);
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cmath>
+
+#include "agentlink.hpp"
+#include "types.hpp"
+
+// Minimal external agent for "main --agent": steers greedily at the food, around walls right
+// in front of it, and reports
+// the stepping rate, e.g. "snakeagent -n 1000000 -s 7"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cerr << "usage: snakeagent [-n ticks] [-s seed]\n"
+                  << "  -n  ticks to step before detaching (default 100000)\n"
+                  << "  -s  food seed of the first episode, later episodes count up (default 1)\n";
+    }
+
+    // The world border counts as a wall
+    bool isWall(const AgentMap &map, float x, float y)
+    {
+        if (x < 0 || y < 0)
+            return true;
+        auto column = static_cast<std::uint32_t>(x / map.tileSize);
+        auto row = static_cast<std::uint32_t>(y / map.tileSize);
+        if (column >= map.columns || row >= map.rows)
+            return true;
+        return map.walls[row * map.columns + column] != 0;
+    }
+
+    // A turn can land up to 20 ticks after it's asked for, 80 pixels, and the head reaches a
+    // tile past its center, so that much of the strip the snake's width covers must be open
+    constexpr float lookaheadTiles = 4.0f;
+
+    bool isBlocked(const AgentMap &map, const AgentPoint &head, moveDirection direction)
+    {
+        float forwardX = 0, forwardY = 0;
+        switch (direction)
+        {
+        case moveDirection::Up:
+            forwardY = -1;
+            break;
+        case moveDirection::Down:
+            forwardY = 1;
+            break;
+        case moveDirection::Left:
+            forwardX = -1;
+            break;
+        case moveDirection::Right:
+            forwardX = 1;
+            break;
+        }
+
+        // Half a tile apart along the strip, at both edges and the middle across it
+        const float edge = map.tileSize - 1.0f;
+        for (float along = map.tileSize / 2; along <= lookaheadTiles * map.tileSize; along += map.tileSize / 2)
+        {
+            for (float across : {-edge, 0.0f, edge})
+            {
+                float x = head.x + forwardX * along + forwardY * across;
+                float y = head.y + forwardY * along + forwardX * across;
+                if (isWall(map, x, y))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    moveDirection opposite(moveDirection direction)
+    {
+        switch (direction)
+        {
+        case moveDirection::Up:
+            return moveDirection::Down;
+        case moveDirection::Down:
+            return moveDirection::Up;
+        case moveDirection::Left:
+            return moveDirection::Right;
+        case moveDirection::Right:
+            return moveDirection::Left;
+        }
+        return direction;
+    }
+
+    std::uint32_t chooseDirection(const AgentObservation &observation, const AgentMap &map)
+    {
+        float dx = observation.food.x - observation.head.x;
+        float dy = observation.food.y - observation.head.y;
+        moveDirection horizontal = dx > 0 ? moveDirection::Right : moveDirection::Left;
+        moveDirection vertical = dy > 0 ? moveDirection::Down : moveDirection::Up;
+
+        // Towards the food on the longer axis first, then the shorter. Blocked both ways, it keeps
+        // going along the wall rather than turning back and forth in front of it.
+        const bool horizontalFirst = std::abs(dx) > std::abs(dy);
+        const moveDirection first = horizontalFirst ? horizontal : vertical;
+        const moveDirection second = horizontalFirst ? vertical : horizontal;
+        const auto current = static_cast<moveDirection>(observation.direction);
+        const moveDirection order[5] = {first, second, current, opposite(second), opposite(first)};
+
+        // Walls out of reach aren't worth the probes
+        if (observation.wallClearance > lookaheadTiles + 1 && first != opposite(current))
+            return static_cast<std::uint32_t>(first);
+
+        for (moveDirection want : order)
+        {
+            if (want != opposite(current) && !isBlocked(map, observation.head, want))
+                return static_cast<std::uint32_t>(want);
+        }
+        return AGENT_ACTION_KEEP;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long ticks = 100000;
+    std::uint32_t seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            ticks = std::stoull(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            seed = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    AgentLink link;
+    if (!link.attach())
+    {
+        std::cerr << "snakeagent: no agent segment found, is \"main --agent\" running?\n";
+        return 1;
+    }
+
+    AgentAction action{AGENT_ACTION_KEEP, 1, seed, 0};
+    std::uint32_t pendingTurn = AGENT_ACTION_KEEP; // Sent but not applied yet
+    unsigned long long episodes = 0;
+    long long bestScore = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned long long n = 0; n < ticks; ++n)
+    {
+        const AgentObservation *observation = link.waitForObservation();
+        if (observation == nullptr)
+        {
+            std::cerr << "snakeagent: game went away\n";
+            break;
+        }
+
+        if (n == 0 || observation->done)
+        {
+            if (observation->score > bestScore)
+                bestScore = observation->score;
+            action = {AGENT_ACTION_KEEP, 1, seed + static_cast<std::uint32_t>(episodes), 0};
+            pendingTurn = AGENT_ACTION_KEEP;
+            episodes++;
+        }
+        else
+        {
+            // The game queues turns until the snake may turn, more of them would go stale in the queue
+            if (pendingTurn == observation->direction)
+                pendingTurn = AGENT_ACTION_KEEP;
+            std::uint32_t direction = AGENT_ACTION_KEEP;
+            if (pendingTurn == AGENT_ACTION_KEEP)
+                direction = chooseDirection(*observation, link.getMap());
+            if (direction != AGENT_ACTION_KEEP && direction != observation->direction)
+                pendingTurn = direction;
+            action = {direction, 0, 0, 0};
+        }
+
+        link.act(action);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << ticks << " ticks, " << episodes << " episodes, best score " << bestScore << ", "
+              << static_cast<unsigned long long>(ticks / (seconds > 0 ? seconds : 1e-9)) << " ticks/s\n";
+
+    return 0;
+}
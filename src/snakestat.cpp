@@ -0,0 +1,93 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "statsshm.hpp"
+
+// Samples the live stats segment of a running game, e.g. "snakestat -i 10 -n 500"
+
+namespace
+{
+    const char *stateName(std::uint32_t state)
+    {
+        static const char *names[] = {"MENU", "USERNAME_INPUT", "PLAYING", "PAUSED", "GAME_OVER", "ARENA", "GRID", "QUIT"};
+        return state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: snakestat [-i interval_ms] [-n samples]\n"
+                  << "  -i  time between samples in milliseconds, fractions allowed (default 1000)\n"
+                  << "  -n  number of samples, 0 runs until interrupted (default 0)\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double intervalMs = 1000.0;
+    long samples = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-i" && i + 1 < argc)
+            intervalMs = std::stod(argv[++i]);
+        else if (arg == "-n" && i + 1 < argc)
+            samples = std::stol(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    StatsReader reader;
+    if (!reader.isOpen())
+    {
+        std::cerr << "snakestat: no stats segment found, is the game running?\n";
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "frame" << std::setw(10) << "ticks"
+              << std::setw(9) << "ms" << std::setw(9) << "avg ms" << std::setw(9) << "max ms"
+              << std::setw(8) << "tick/s" << std::setw(9) << "lat ms" << std::setw(7) << "len"
+              << std::setw(8) << "score" << std::setw(11) << "assets KB" << std::setw(7) << "voices"
+              << std::setw(8) << "steals" << "  state\n";
+
+    auto interval = std::chrono::duration<double, std::milli>(intervalMs);
+    auto next = std::chrono::steady_clock::now();
+    for (long n = 0; samples == 0 || n < samples; ++n)
+    {
+        StatsCounters counters;
+        if (!reader.sample(counters))
+        {
+            if (!reader.hasValidLayout())
+            {
+                std::cerr << "snakestat: stats segment has an unknown layout\n";
+                return 1;
+            }
+
+            // Keeps watching, a frozen game may still come back
+            std::cout << "writer stalled, the game stopped partway through publishing\n";
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+            continue;
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << counters.frameCount << std::setw(10) << counters.tickCount
+                  << std::setw(9) << counters.frameTimeMs << std::setw(9) << counters.frameTimeAverageMs
+                  << std::setw(9) << counters.frameTimeMaxMs << std::setw(8) << std::setprecision(0) << counters.ticksPerSecond
+                  << std::setw(9) << std::setprecision(2) << counters.inputLatencyMs
+                  << std::setw(7) << counters.snakeLength << std::setw(8) << counters.score
+                  << std::setw(11) << counters.assetBytes / 1024 << std::setw(7) << counters.sfxActiveVoices
+                  << std::setw(8) << counters.sfxSteals << "  " << stateName(counters.gameState) << '\n';
+
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+        std::this_thread::sleep_until(next);
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <fstream>
+#include <cstring>
+
+#include "snapshot.hpp"
+#include "binaryio.hpp"
+
+namespace
+{
+    // Header: magic, version, payload size, payload checksum
+    constexpr size_t headerSize = 4 * sizeof(std::uint32_t);
+
+    class Writer
+    {
+    public:
+        explicit Writer(std::vector<char> &out) : out(out) {}
+
+        template <typename T>
+        void put(const T &value)
+        {
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        void putBytes(const void *data, size_t size)
+        {
+            const char *bytes = static_cast<const char *>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        }
+
+    private:
+        std::vector<char> &out;
+    };
+}
+
+std::vector<char> GameSnapshot::encode() const
+{
+    std::vector<char> bytes;
+    bytes.reserve(headerSize + 64 + tail.size() * 13 + (corners.size() + positionHistory.size()) * sizeof(SimVector) + username.size());
+
+    Writer out(bytes);
+    out.put(SNAPSHOT_MAGIC);
+    out.put(SNAPSHOT_VERSION);
+    out.put(std::uint32_t{0}); // Payload size, patched below
+    out.put(std::uint32_t{0}); // Checksum, patched below
+
+    out.put(headPosition.x);
+    out.put(headPosition.y);
+    out.put(static_cast<std::uint8_t>(direction));
+    out.put(static_cast<std::uint8_t>(previousDirection));
+    out.put(framesSinceTurn);
+
+    out.put(static_cast<std::uint32_t>(tail.size()));
+    for (const auto &segment : tail)
+    {
+        out.put(segment.position.x);
+        out.put(segment.position.y);
+        out.put(segment.freezeFrames);
+        out.put(static_cast<std::uint8_t>(segment.isFrozen));
+    }
+
+    out.put(static_cast<std::uint32_t>(corners.size()));
+    out.putBytes(corners.data(), corners.size() * sizeof(SimVector));
+
+    out.put(static_cast<std::uint32_t>(positionHistory.size()));
+    out.putBytes(positionHistory.data(), positionHistory.size() * sizeof(SimVector));
+
+    out.put(foodPosition.x);
+    out.put(foodPosition.y);
+    out.put(score);
+    out.putBytes(rngState.words, sizeof(rngState.words));
+    out.put(rngState.index);
+
+    out.put(static_cast<std::uint32_t>(username.size()));
+    out.putBytes(username.data(), username.size());
+
+    std::uint32_t payloadSize = static_cast<std::uint32_t>(bytes.size() - headerSize);
+    std::uint32_t payloadHash = checksum(bytes.data() + headerSize, payloadSize);
+    std::memcpy(bytes.data() + 2 * sizeof(std::uint32_t), &payloadSize, sizeof(payloadSize));
+    std::memcpy(bytes.data() + 3 * sizeof(std::uint32_t), &payloadHash, sizeof(payloadHash));
+
+    return bytes;
+}
+
+bool GameSnapshot::decode(const std::vector<char> &bytes)
+{
+    ByteReader in(bytes.data(), bytes.size());
+
+    std::uint32_t magic, version, payloadSize, payloadHash;
+    if (!in.get(magic) || !in.get(version) || !in.get(payloadSize) || !in.get(payloadHash))
+        return false;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION)
+        return false;
+    if (payloadSize != bytes.size() - headerSize || checksum(bytes.data() + headerSize, payloadSize) != payloadHash)
+        return false;
+
+    std::uint8_t dir, prevDir;
+    if (!in.get(headPosition.x) || !in.get(headPosition.y) || !in.get(dir) || !in.get(prevDir) || !in.get(framesSinceTurn))
+        return false;
+    if (dir > static_cast<std::uint8_t>(moveDirection::Right) || prevDir > static_cast<std::uint8_t>(moveDirection::Right))
+        return false;
+    direction = static_cast<moveDirection>(dir);
+    previousDirection = static_cast<moveDirection>(prevDir);
+
+    std::uint32_t count;
+    if (!in.getCount(count, 13))
+        return false;
+    tail.resize(count);
+    for (auto &segment : tail)
+    {
+        std::uint8_t frozen;
+        if (!in.get(segment.position.x) || !in.get(segment.position.y) || !in.get(segment.freezeFrames) || !in.get(frozen))
+            return false;
+        segment.isFrozen = frozen != 0;
+    }
+
+    if (!in.getCount(count, sizeof(SimVector)))
+        return false;
+    corners.resize(count);
+    in.getBytes(corners.data(), count * sizeof(SimVector));
+
+    if (!in.getCount(count, sizeof(SimVector)))
+        return false;
+    positionHistory.resize(count);
+    in.getBytes(positionHistory.data(), count * sizeof(SimVector));
+
+    if (!in.get(foodPosition.x) || !in.get(foodPosition.y) || !in.get(score))
+        return false;
+    if (!in.getBytes(rngState.words, sizeof(rngState.words)) || !in.get(rngState.index) || rngState.index > SPAWN_RNG_WORDS)
+        return false;
+
+    if (!in.getCount(count, 1))
+        return false;
+    username.resize(count);
+    in.getBytes(username.data(), count);
+
+    return in.atEnd();
+}
+
+bool writeSnapshotFile(const std::string &filename, const std::vector<char> &bytes)
+{
+    return writeFileAtomically(filename, bytes);
+}
+
+bool readSnapshotFile(const std::string &filename, std::vector<char> &bytes)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+
+    std::streamsize size = file.tellg();
+    if (size <= 0)
+        return false;
+
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return static_cast<bool>(file.read(bytes.data(), size));
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "types.hpp"
+#include "fixedpoint.hpp"
+#include "player.hpp"
+
+#define SNAPSHOT_FILE "savegame.bin"
+#define SNAPSHOT_MAGIC 0x534E4B53u // "SNKS"
+#define SNAPSHOT_VERSION 3u // 2: fixed point positions, 3: raw rng state
+
+struct TailState
+{
+    SimVector position;
+    std::int32_t freezeFrames;
+    bool isFrozen;
+};
+
+// Everything needed to continue a run exactly where it was paused
+struct GameSnapshot
+{
+    SimVector headPosition;
+    moveDirection direction = moveDirection::Right;
+    moveDirection previousDirection = moveDirection::Right;
+    std::int32_t framesSinceTurn = 0;
+    std::vector<TailState> tail;
+    std::vector<SimVector> corners;
+    std::vector<SimVector> positionHistory;
+    SimVector foodPosition;
+    std::int32_t score = 0;
+    SpawnRngState rngState {};
+    std::string username;
+
+    std::vector<char> encode() const;
+    bool decode(const std::vector<char> &bytes);
+};
+
+// File helpers, the writer is safe to call from a worker thread
+bool writeSnapshotFile(const std::string &filename, const std::vector<char> &bytes);
+bool readSnapshotFile(const std::string &filename, std::vector<char> &bytes);
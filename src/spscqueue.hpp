@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single producer, single consumer ring. Neither side locks or blocks:
+// push fails when the ring is full and pop fails when it is empty.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer thread only
+    bool push(T &&value)
+    {
+        std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headCache == Capacity)
+        {
+            headCache = headIndex.load(std::memory_order_acquire);
+            if (tail - headCache == Capacity)
+                return false;
+        }
+
+        slots[tail & (Capacity - 1)] = std::move(value);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T &value)
+    {
+        std::size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailCache)
+        {
+            tailCache = tailIndex.load(std::memory_order_acquire);
+            if (head == tailCache)
+                return false;
+        }
+
+        value = std::move(slots[head & (Capacity - 1)]);
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Each side keeps a stale copy of the other's index and only rereads it when the ring looks full/empty
+    alignas(64) std::atomic<std::size_t> headIndex{0};
+    std::size_t tailCache = 0;
+    alignas(64) std::atomic<std::size_t> tailIndex{0};
+    std::size_t headCache = 0;
+    alignas(64) std::array<T, Capacity> slots;
+};
@@ -0,0 +1,67 @@
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include "statsshm.hpp"
+
+StatsPublisher::StatsPublisher()
+{
+    if (!memory.create(STATS_SEGMENT_NAME, sizeof(StatsSegment)))
+        return;
+
+    segment = new (memory.data()) StatsSegment();
+    std::memset(&segment->counters, 0, sizeof(segment->counters));
+    segment->magic = STATS_SEGMENT_MAGIC;
+    segment->version = STATS_SEGMENT_VERSION;
+    segment->sequence.store(0, std::memory_order_release);
+}
+
+void StatsPublisher::publish(const StatsCounters &counters)
+{
+    if (segment == nullptr)
+        return;
+
+    // Single writer, so plain load/store on the sequence is enough
+    std::uint32_t sequence = segment->sequence.load(std::memory_order_relaxed);
+    segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&segment->counters, &counters, sizeof(counters));
+
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+StatsReader::StatsReader()
+{
+    if (memory.open(STATS_SEGMENT_NAME, sizeof(StatsSegment), false))
+        segment = static_cast<const StatsSegment *>(memory.data());
+}
+
+bool StatsReader::hasValidLayout() const
+{
+    return segment != nullptr && segment->magic == STATS_SEGMENT_MAGIC && segment->version == STATS_SEGMENT_VERSION;
+}
+
+bool StatsReader::sample(StatsCounters &counters) const
+{
+    if (!hasValidLayout())
+        return false;
+
+    // A game that died or froze mid-publish leaves the sequence odd for good
+    for (int attempt = 0; attempt < STATS_READ_ATTEMPTS; ++attempt)
+    {
+        std::uint32_t before = segment->sequence.load(std::memory_order_acquire);
+        if (before & 1u)
+        {
+            std::this_thread::yield(); // Writer is mid-update
+            continue;
+        }
+
+        std::memcpy(&counters, &segment->counters, sizeof(counters));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (segment->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "sharedmemory.hpp"
+
+#define STATS_SEGMENT_NAME "snake_stats"
+#define STATS_SEGMENT_MAGIC 0x534E5354u // "SNST"
+#define STATS_SEGMENT_VERSION 2u
+#define STATS_READ_ATTEMPTS 10000 // Tries at a consistent copy before the writer counts as stalled mid-publish
+
+// Plain counters, copied as one block under the sequence lock
+struct StatsCounters
+{
+    std::uint64_t frameCount;
+    std::uint64_t tickCount;
+    float frameTimeMs;        // Last frame
+    float frameTimeAverageMs; // Exponential moving average
+    float frameTimeMaxMs;     // Worst frame in the last second
+    float ticksPerSecond;
+    float inputLatencyMs;
+    float inputLatencyAverageMs;
+    std::uint32_t snakeLength;
+    std::int32_t score;
+    std::uint32_t gameState; // GameState value
+    std::uint32_t reserved;
+    std::uint64_t assetBytes;
+    std::uint32_t sfxActiveVoices;
+    std::uint32_t sfxSteals; // Since startup
+};
+
+// Layout of the shared segment. Readers never block the writer: the sequence is odd while
+// an update is in progress and a reader retries if it changed during its copy.
+struct StatsSegment
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint32_t> sequence;
+    std::uint32_t padding;
+    StatsCounters counters;
+};
+
+// Game side: creates the segment and publishes into it once per frame
+class StatsPublisher
+{
+public:
+    StatsPublisher();
+
+    StatsPublisher(const StatsPublisher &) = delete;
+    StatsPublisher &operator=(const StatsPublisher &) = delete;
+
+    bool isOpen() const { return segment != nullptr; }
+    void publish(const StatsCounters &counters);
+
+private:
+    SharedMemory memory;
+    StatsSegment *segment = nullptr;
+};
+
+// Monitor side: maps an existing segment read-only
+class StatsReader
+{
+public:
+    StatsReader();
+
+    StatsReader(const StatsReader &) = delete;
+    StatsReader &operator=(const StatsReader &) = delete;
+
+    bool isOpen() const { return segment != nullptr; }
+    bool hasValidLayout() const;
+    // Consistent copy of the latest counters, false if the segment isn't a valid stats segment
+    // or the writer stopped halfway through publishing
+    bool sample(StatsCounters &counters) const;
+
+private:
+    SharedMemory memory;
+    const StatsSegment *segment = nullptr;
+};
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#include "telemetry.hpp"
+#include "binaryio.hpp"
+
+namespace
+{
+    constexpr size_t recordHeaderSize = 2 * sizeof(std::uint32_t);
+    constexpr size_t fileHeaderSize = 2 * sizeof(std::uint32_t);
+    constexpr size_t maxUsername = 255;
+
+    void putWord(std::vector<char> &out, size_t at, std::uint32_t value)
+    {
+        std::memcpy(out.data() + at, &value, sizeof(value));
+    }
+
+    bool decodePayload(const char *data, size_t size, SessionRecord &record)
+    {
+        ByteReader in(data, size);
+
+        std::uint64_t score;
+        std::uint8_t flags;
+        std::uint8_t nameLength;
+        if (!in.getVarint(record.startTime) || !in.getVarint(record.durationMs) || !in.getVarint(score) ||
+            !in.getVarint(record.length) || !in.getVarint(record.turns) || !in.getVarint(record.ticks) ||
+            !in.getBytes(&record.deathCause, 1) || !in.getBytes(&flags, 1) || !in.getBytes(&nameLength, 1))
+            return false;
+        record.score = static_cast<std::int32_t>(score);
+        record.autopilot = (flags & 1u) != 0;
+
+        record.username.resize(nameLength);
+        if (!in.getBytes(&record.username[0], nameLength))
+            return false;
+
+        std::uint64_t usedBins;
+        if (!in.getVarint(usedBins) || usedBins > TELEMETRY_HISTOGRAM_BINS)
+            return false;
+        record.frames = FrameHistogram();
+        for (std::uint64_t i = 0; i < usedBins; ++i)
+        {
+            std::uint8_t bin;
+            std::uint32_t count;
+            if (!in.getBytes(&bin, 1) || bin >= TELEMETRY_HISTOGRAM_BINS || !in.getVarint(count))
+                return false;
+            record.frames.bins[bin] = count;
+        }
+
+        return in.atEnd();
+    }
+}
+
+void FrameHistogram::add(float ms)
+{
+    int bin = static_cast<int>(ms * 1000.0f / TELEMETRY_BIN_US);
+    bins[std::clamp(bin, 0, TELEMETRY_HISTOGRAM_BINS - 1)]++;
+}
+
+void FrameHistogram::merge(const FrameHistogram &other)
+{
+    for (int i = 0; i < TELEMETRY_HISTOGRAM_BINS; ++i)
+        bins[i] += other.bins[i];
+}
+
+std::uint64_t FrameHistogram::total() const
+{
+    std::uint64_t sum = 0;
+    for (std::uint32_t count : bins)
+        sum += count;
+    return sum;
+}
+
+float FrameHistogram::percentile(double fraction) const
+{
+    std::uint64_t count = total();
+    if (count == 0)
+        return 0.0f;
+
+    std::uint64_t wanted = std::min(static_cast<std::uint64_t>(fraction * count), count - 1);
+    std::uint64_t seen = 0;
+    for (int i = 0; i < TELEMETRY_HISTOGRAM_BINS; ++i)
+    {
+        seen += bins[i];
+        if (seen > wanted)
+            return (i + 1) * TELEMETRY_BIN_US / 1000.0f;
+    }
+    return TELEMETRY_HISTOGRAM_BINS * TELEMETRY_BIN_US / 1000.0f;
+}
+
+void encodeSessionRecord(const SessionRecord &record, std::vector<char> &out)
+{
+    size_t header = out.size();
+    out.resize(header + recordHeaderSize);
+    size_t payload = out.size();
+
+    putVarint(out, record.startTime);
+    putVarint(out, record.durationMs);
+    putVarint(out, static_cast<std::uint64_t>(std::max(record.score, 0)));
+    putVarint(out, record.length);
+    putVarint(out, record.turns);
+    putVarint(out, record.ticks);
+    out.push_back(static_cast<char>(record.deathCause));
+    out.push_back(static_cast<char>(record.autopilot ? 1 : 0));
+
+    size_t nameLength = std::min(record.username.size(), maxUsername);
+    out.push_back(static_cast<char>(nameLength));
+    out.insert(out.end(), record.username.begin(), record.username.begin() + nameLength);
+
+    int usedBins = 0;
+    for (std::uint32_t count : record.frames.bins)
+        usedBins += count != 0;
+    putVarint(out, usedBins);
+    for (int i = 0; i < TELEMETRY_HISTOGRAM_BINS; ++i)
+    {
+        if (record.frames.bins[i] == 0)
+            continue;
+        out.push_back(static_cast<char>(i));
+        putVarint(out, record.frames.bins[i]);
+    }
+
+    size_t payloadSize = out.size() - payload;
+    putWord(out, header, static_cast<std::uint32_t>(payloadSize));
+    putWord(out, header + sizeof(std::uint32_t), checksum(out.data() + payload, payloadSize));
+}
+
+namespace
+{
+    bool hasLogHeader(const std::vector<char> &bytes)
+    {
+        if (bytes.size() < fileHeaderSize)
+            return false;
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::memcpy(&magic, bytes.data(), sizeof(magic));
+        std::memcpy(&version, bytes.data() + sizeof(magic), sizeof(version));
+        return magic == TELEMETRY_MAGIC && version == TELEMETRY_VERSION;
+    }
+
+    // Where the last record that checks out ends, anything after it is what a crash left behind
+    size_t intactLength(const std::vector<char> &bytes)
+    {
+        size_t at = fileHeaderSize;
+        size_t intact = at;
+        while (bytes.size() - at >= recordHeaderSize)
+        {
+            std::uint32_t size;
+            std::uint32_t sum;
+            std::memcpy(&size, bytes.data() + at, sizeof(size));
+            std::memcpy(&sum, bytes.data() + at + sizeof(size), sizeof(sum));
+            at += recordHeaderSize;
+            if (size > bytes.size() - at)
+                break;
+
+            at += size;
+            if (checksum(bytes.data() + at - size, size) == sum)
+                intact = at;
+        }
+        return intact;
+    }
+}
+
+bool readSessionLog(const std::string &filename, std::vector<SessionRecord> &records, size_t &corrupt)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!hasLogHeader(bytes))
+        return false;
+
+    size_t at = fileHeaderSize;
+    while (bytes.size() - at >= recordHeaderSize)
+    {
+        std::uint32_t size;
+        std::uint32_t sum;
+        std::memcpy(&size, bytes.data() + at, sizeof(size));
+        std::memcpy(&sum, bytes.data() + at + sizeof(size), sizeof(sum));
+        at += recordHeaderSize;
+        if (size > bytes.size() - at)
+            break; // Torn write at the end
+
+        SessionRecord record;
+        if (checksum(bytes.data() + at, size) == sum && decodePayload(bytes.data() + at, size, record))
+            records.push_back(std::move(record));
+        else
+            corrupt++;
+        at += size;
+    }
+
+    return true;
+}
+
+TelemetryWriter::TelemetryWriter(const std::string &filename)
+    : filename(filename), thread(&TelemetryWriter::writerLoop, this)
+{
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping.store(true, std::memory_order_release);
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+bool TelemetryWriter::submit(SessionRecord &&record)
+{
+    if (!queue.push(std::move(record)))
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // No lock here, a missed wake-up only delays the write until the next flush interval
+    wake.notify_one();
+    return true;
+}
+
+void TelemetryWriter::writerLoop()
+{
+    std::vector<char> batch;
+    while (true)
+    {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(TELEMETRY_FLUSH_MS));
+            stop = stopping.load(std::memory_order_acquire);
+        }
+
+        drain(batch);
+        if (stop)
+            return;
+    }
+}
+
+void TelemetryWriter::drain(std::vector<char> &batch)
+{
+    batch.clear();
+    std::uint64_t count = 0;
+    SessionRecord record;
+    while (queue.pop(record))
+    {
+        encodeSessionRecord(record, batch);
+        count++;
+    }
+    if (count == 0)
+        return;
+
+    if (!repaired)
+    {
+        repairLog();
+        repaired = true;
+    }
+
+    // New log, start with the file header
+    std::error_code error;
+    bool fresh = !std::filesystem::exists(filename, error) || std::filesystem::file_size(filename, error) == 0;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::app);
+    if (!file)
+        return;
+
+    if (fresh)
+    {
+        std::uint32_t header[2] = {TELEMETRY_MAGIC, TELEMETRY_VERSION};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+    file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    file.flush();
+    if (file)
+        written.fetch_add(count, std::memory_order_relaxed);
+}
+
+void TelemetryWriter::repairLog()
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return;
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    // Appending after a torn record would have the reader jump into the middle of the new ones.
+    // A header torn in half starts the log over, a file that isn't a session log is left alone.
+    std::error_code error;
+    if (bytes.size() < fileHeaderSize)
+        std::filesystem::resize_file(filename, 0, error);
+    else if (hasLogHeader(bytes))
+    {
+        const size_t intact = intactLength(bytes);
+        if (intact < bytes.size())
+            std::filesystem::resize_file(filename, intact, error);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spscqueue.hpp"
+
+#define TELEMETRY_FILE "sessions.bin"
+#define TELEMETRY_MAGIC 0x534E4B54u // "SNKT"
+#define TELEMETRY_VERSION 1u
+#define TELEMETRY_BIN_US 500          // Width of one frame time bin
+#define TELEMETRY_HISTOGRAM_BINS 64   // The last bin takes everything slower
+#define TELEMETRY_QUEUE_SIZE 16
+#define TELEMETRY_FLUSH_MS 500        // Longest the writer sleeps without checking the queue
+
+// Frame times in fixed 0.5 ms bins
+struct FrameHistogram
+{
+    std::uint32_t bins[TELEMETRY_HISTOGRAM_BINS] = {};
+
+    void add(float ms);
+    void merge(const FrameHistogram &other);
+    std::uint64_t total() const;
+    // Upper edge of the bin holding the given fraction of frames, in ms
+    float percentile(double fraction) const;
+};
+
+// One run from start to game over (or to the menu from pause)
+struct SessionRecord
+{
+    std::uint64_t startTime = 0;  // Unix seconds
+    std::uint32_t durationMs = 0; // Time spent PLAYING
+    std::int32_t score = 0;
+    std::uint32_t length = 0;     // Head plus tail segments
+    std::uint32_t turns = 0;
+    std::uint64_t ticks = 0;
+    std::uint8_t deathCause = 0;  // DeathCause value, None for an abandoned run
+    bool autopilot = false;       // The autopilot drove at some point
+    std::string username;
+    FrameHistogram frames;
+};
+
+// Log format: magic and version once, then records of {payload size, FNV-1a checksum, payload}.
+// Payload integers are LEB128 varints and the histogram only stores bins that were hit.
+void encodeSessionRecord(const SessionRecord &record, std::vector<char> &out);
+// Reads every intact record. A record torn by a crash is cut off before the next append, so it
+// can only ever be the last one.
+bool readSessionLog(const std::string &filename, std::vector<SessionRecord> &records, size_t &corrupt);
+
+// Appends records from a background thread. submit() is lock-free and never waits on the disk.
+class TelemetryWriter
+{
+public:
+    explicit TelemetryWriter(const std::string &filename = TELEMETRY_FILE);
+    ~TelemetryWriter();
+
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+    // Game thread only; false (and counted as dropped) if the writer has fallen far behind
+    bool submit(SessionRecord &&record);
+
+    std::uint64_t getWritten() const { return written.load(std::memory_order_relaxed); }
+    std::uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void writerLoop();
+    void drain(std::vector<char> &batch);
+    void repairLog();
+
+    std::string filename;
+    bool repaired = false; // Writer thread only
+    SpscQueue<SessionRecord, TELEMETRY_QUEUE_SIZE> queue;
+    std::atomic<bool> stopping{false};
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::mutex wakeMutex; // Only the writer ever sleeps on this
+    std::condition_variable wake;
+    std::thread thread;
+};
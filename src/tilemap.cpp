@@ -0,0 +1,242 @@
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include "tilemap.hpp"
+
+namespace
+{
+    constexpr SimCoord tileSize = toSim(MAP_TILE_SIZE);
+
+    SimCoord floorDiv(SimCoord value, SimCoord divisor)
+    {
+        SimCoord quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+}
+
+TileMap::TileMap(int columns, int rows)
+    : columns(columns), rows(rows)
+{
+    clear();
+}
+
+void TileMap::clear()
+{
+    walls.assign(static_cast<size_t>(columns) * rows, 0);
+    bake();
+}
+
+bool TileMap::loadFromFile(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        std::cerr << "Could not open map " << filename << std::endl;
+        clear();
+        return false;
+    }
+
+    if (!parse(file))
+    {
+        std::cerr << "Map " << filename << " is not a " << columns << "x" << rows << " tile map" << std::endl;
+        clear();
+        return false;
+    }
+
+    bake();
+    return true;
+}
+
+bool TileMap::parse(std::istream &in)
+{
+    walls.assign(static_cast<size_t>(columns) * rows, 0);
+
+    std::string line;
+    bool sized = false;
+    int y = 0;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == ';')
+            continue;
+
+        if (!sized)
+        {
+            std::istringstream header(line);
+            std::string keyword;
+            int width = 0, height = 0;
+            if (!(header >> keyword >> width >> height) || keyword != "size" || width != columns || height != rows)
+                return false;
+            sized = true;
+            continue;
+        }
+
+        // One row of runs, optionally repeated
+        std::vector<std::uint8_t> row;
+        row.reserve(columns);
+        int repeat = 1;
+        size_t i = 0;
+        while (i < line.size())
+        {
+            if (line[i] == '\r' || line[i] == ' ')
+            {
+                ++i;
+                continue;
+            }
+
+            int count = 0;
+            bool counted = false;
+            while (i < line.size() && line[i] >= '0' && line[i] <= '9')
+            {
+                count = count * 10 + (line[i++] - '0');
+                counted = true;
+                if (count > columns * rows)
+                    return false;
+            }
+            if (i == line.size())
+                return false;
+
+            char tile = line[i++];
+            if (tile == '*')
+            {
+                // Repeat count of the whole row
+                repeat = 0;
+                while (i < line.size() && line[i] >= '0' && line[i] <= '9')
+                    repeat = repeat * 10 + (line[i++] - '0');
+                if (repeat <= 0 || repeat > rows)
+                    return false;
+                continue;
+            }
+            if (tile != '.' && tile != '#')
+                return false;
+
+            row.insert(row.end(), counted ? count : 1, tile == '#' ? 1 : 0);
+            if (static_cast<int>(row.size()) > columns)
+                return false;
+        }
+
+        if (static_cast<int>(row.size()) != columns || y + repeat > rows)
+            return false;
+        for (int r = 0; r < repeat; ++r, ++y)
+            std::copy(row.begin(), row.end(), walls.begin() + static_cast<size_t>(y) * columns);
+    }
+
+    return sized && y == rows;
+}
+
+void TileMap::bake()
+{
+    // Summed-area table: entry (x, y) holds the walls in tiles [0, x) x [0, y)
+    const int stride = columns + 1;
+    summedArea.assign(static_cast<size_t>(stride) * (rows + 1), 0);
+    for (int y = 0; y < rows; ++y)
+    {
+        std::uint32_t rowSum = 0;
+        for (int x = 0; x < columns; ++x)
+        {
+            rowSum += walls[y * columns + x];
+            summedArea[(y + 1) * stride + x + 1] = summedArea[y * stride + x + 1] + rowSum;
+        }
+    }
+    wallCount = summedArea.back();
+
+    // Chessboard distance to the nearest wall in two passes, forward then backward
+    distance.assign(walls.size(), 255);
+    for (size_t i = 0; i < walls.size(); ++i)
+        if (walls[i])
+            distance[i] = 0;
+    if (wallCount == 0)
+        return;
+
+    auto relax = [&](int x, int y, int dx, int dy)
+    {
+        int nx = x + dx;
+        int ny = y + dy;
+        if (nx < 0 || ny < 0 || nx >= columns || ny >= rows)
+            return;
+        std::uint8_t &here = distance[y * columns + x];
+        here = static_cast<std::uint8_t>(std::min<int>(here, distance[ny * columns + nx] + 1));
+    };
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < columns; ++x)
+        {
+            relax(x, y, -1, 0);
+            relax(x, y, -1, -1);
+            relax(x, y, 0, -1);
+            relax(x, y, 1, -1);
+        }
+    }
+    for (int y = rows - 1; y >= 0; --y)
+    {
+        for (int x = columns - 1; x >= 0; --x)
+        {
+            relax(x, y, 1, 0);
+            relax(x, y, 1, 1);
+            relax(x, y, 0, 1);
+            relax(x, y, -1, 1);
+        }
+    }
+}
+
+std::uint32_t TileMap::wallsIn(int x0, int y0, int x1, int y1) const
+{
+    const int stride = columns + 1;
+    return summedArea[(y1 + 1) * stride + x1 + 1] - summedArea[y0 * stride + x1 + 1] -
+           summedArea[(y1 + 1) * stride + x0] + summedArea[y0 * stride + x0];
+}
+
+bool TileMap::overlapsWall(SimVector center, SimCoord halfSize) const
+{
+    if (wallCount == 0)
+        return false;
+
+    // Tiles the open interval (center - half, center + half) reaches into; outside the map is open
+    int x0 = std::max(floorDiv(center.x - halfSize, tileSize), 0);
+    int y0 = std::max(floorDiv(center.y - halfSize, tileSize), 0);
+    int x1 = std::min(floorDiv(center.x + halfSize - 1, tileSize), columns - 1);
+    int y1 = std::min(floorDiv(center.y + halfSize - 1, tileSize), rows - 1);
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    return wallsIn(x0, y0, x1, y1) != 0;
+}
+
+SimCoord TileMap::firstWallHit(const SimSweep &sweep, SimCoord halfSize) const
+{
+    // Nothing anywhere along the move, one lookup for the box covering all of it
+    SimVector lo = sweep.start;
+    SimVector hi = sweep.at(sweep.length);
+    SimVector center{(lo.x + hi.x) / 2, (lo.y + hi.y) / 2};
+    SimCoord spread = (sweep.length + 1) / 2;
+    if (!overlapsWall(center, halfSize + spread))
+        return -1;
+
+    // The set of touched tiles only grows when the leading edge crosses into a new tile,
+    // so those distances (and the start) are the only ones worth testing
+    const SimCoord start = sweep.axis == 0 ? sweep.start.x : sweep.start.y;
+    SimCoord distance = 0;
+    while (distance <= sweep.length)
+    {
+        if (overlapsWall(sweep.at(distance), halfSize))
+            return distance;
+
+        // Distance at which the (open) leading edge gets past the next tile boundary
+        SimCoord edge = start + sweep.sign * (distance + halfSize);
+        SimCoord next;
+        if (sweep.sign > 0)
+            next = (floorDiv(edge - 1, tileSize) + 1) * tileSize - halfSize - start + 1;
+        else
+            next = start - halfSize - floorDiv(edge, tileSize) * tileSize + 1;
+        distance = std::max(next, distance + 1);
+    }
+    return -1;
+}
+
+int TileMap::clearanceAt(SimVector position) const
+{
+    int x = std::clamp(floorDiv(position.x, tileSize), 0, columns - 1);
+    int y = std::clamp(floorDiv(position.y, tileSize), 0, rows - 1);
+    return distance[y * columns + x];
+}
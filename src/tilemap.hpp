@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "fixedpoint.hpp"
+
+#define MAP_FILE "maps/default.map"
+#define MAP_TILE_SIZE 30.0f     // Pixels, half a snake segment so walls can line up with the snake's cells
+#define MAP_FOOD_CLEARANCE 2    // Tiles between food and the nearest wall, leaves room for a whole segment
+
+// Static walls on a tile grid covering the world, read from a run-length encoded text file.
+// Loading bakes a summed-area table of the walls, so any box test is four lookups however many
+// walls there are, and a distance field giving every tile its distance to the nearest wall.
+//
+// File format: "size <columns> <rows>", then one line per row made of runs "<count><tile>"
+// where the tile is '.' (open) or '#' (wall) and a missing count means 1. A row ending in
+// "*<n>" stands for n identical rows. Lines starting with ';' are comments.
+class TileMap
+{
+public:
+    TileMap(int columns, int rows);
+
+    bool loadFromFile(const std::string &filename); // Leaves the map empty on failure
+    void clear();
+
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    bool hasWalls() const { return wallCount > 0; }
+    bool isWall(int x, int y) const { return walls[y * columns + x] != 0; }
+
+    // True when the open box center +- halfSize touches a wall tile
+    bool overlapsWall(SimVector center, SimCoord halfSize) const;
+    // First distance along the sweep where the box hits a wall, -1 if it never does
+    SimCoord firstWallHit(const SimSweep &sweep, SimCoord halfSize) const;
+    // Chessboard distance in tiles from the tile under position to the nearest wall, saturating
+    int clearanceAt(SimVector position) const;
+
+private:
+    bool parse(std::istream &in);
+    void bake();
+    std::uint32_t wallsIn(int x0, int y0, int x1, int y1) const; // Inclusive tile range
+
+    int columns;
+    int rows;
+    std::uint32_t wallCount = 0;
+    std::vector<std::uint8_t> walls;
+    std::vector<std::uint32_t> summedArea; // (columns + 1) x (rows + 1), walls above and left of each corner
+    std::vector<std::uint8_t> distance;
+};
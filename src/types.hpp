@@ -15,5 +15,7 @@ enum class GameState
     PLAYING,
     PAUSED,
     GAME_OVER,
+    ARENA,
+    GRID,
     QUIT
 };
\ No newline at end of file
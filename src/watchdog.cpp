@@ -0,0 +1,382 @@
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "watchdog.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__) && defined(__GLIBC__)
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#define WATCHDOG_SIGNAL_SAMPLING
+#endif
+
+namespace
+{
+    const char *phaseNames[] = {"Frame", "Transition", "Events", "Simulation", "FoodSpawn", "Autopilot",
+                                "Draw", "Present", "Music", "HighScore", "Snapshot", "Stats"};
+    static_assert(sizeof(phaseNames) / sizeof(phaseNames[0]) == static_cast<size_t>(WatchPhase::Count));
+
+    const char *stateNames[] = {"MENU", "USERNAME_INPUT", "PLAYING", "PAUSED", "GAME_OVER", "ARENA", "GRID", "QUIT"};
+
+    // Only the watched thread moves the phase, the watchdog reads it
+    std::atomic<std::uint8_t> currentPhase{0};
+    thread_local bool onWatchedThread = false;
+
+    std::int64_t nowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+#ifdef _WIN32
+    HANDLE watchedThread = nullptr;
+
+    void prepareSampling()
+    {
+        if (watchedThread != nullptr)
+            CloseHandle(watchedThread);
+        if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &watchedThread,
+                             THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0))
+            watchedThread = nullptr;
+    }
+
+    // Suspends the thread and unwinds it from its own context. Nothing in between may allocate,
+    // the suspended thread could be holding the heap lock.
+    int sampleStack(void **frames, int capacity)
+    {
+        if (watchedThread == nullptr || SuspendThread(watchedThread) == static_cast<DWORD>(-1))
+            return 0;
+
+        int depth = 0;
+        CONTEXT context = {};
+        context.ContextFlags = CONTEXT_FULL;
+        if (GetThreadContext(watchedThread, &context))
+        {
+#if defined(_M_X64)
+            while (depth < capacity && context.Rip != 0)
+            {
+                frames[depth++] = reinterpret_cast<void *>(context.Rip);
+
+                DWORD64 imageBase = 0;
+                PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+                if (function == nullptr)
+                {
+                    // Leaf function, the return address is on top of the stack
+                    context.Rip = *reinterpret_cast<DWORD64 *>(context.Rsp);
+                    context.Rsp += sizeof(DWORD64);
+                    continue;
+                }
+
+                void *handlerData = nullptr;
+                DWORD64 establisherFrame = 0;
+                RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context,
+                                 &handlerData, &establisherFrame, nullptr);
+            }
+#elif defined(_M_IX86)
+            frames[depth++] = reinterpret_cast<void *>(context.Eip);
+#endif
+        }
+
+        ResumeThread(watchedThread);
+        return depth;
+    }
+
+    void describeFrame(std::ostream &out, void *address)
+    {
+        HMODULE module = nullptr;
+        char path[MAX_PATH];
+        if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                               static_cast<LPCSTR>(address), &module) &&
+            GetModuleFileNameA(module, path, MAX_PATH) != 0)
+        {
+            out << std::filesystem::path(path).filename().string() << "+0x" << std::hex
+                << (static_cast<char *>(address) - reinterpret_cast<char *>(module)) << std::dec;
+            return;
+        }
+        out << address;
+    }
+#elif defined(WATCHDOG_SIGNAL_SAMPLING)
+    constexpr int sampleSignal = SIGUSR2;
+
+    pthread_t watchedThread;
+    bool samplingReady = false;
+    void *signalFrames[WATCHDOG_STACK_DEPTH];
+    volatile std::sig_atomic_t signalDepth = 0;
+    std::atomic<bool> signalPending{false};
+
+    // Runs on the watched thread wherever it is stuck
+    void onSampleSignal(int)
+    {
+        signalDepth = backtrace(signalFrames, WATCHDOG_STACK_DEPTH);
+        signalPending.store(false, std::memory_order_release);
+    }
+
+    void prepareSampling()
+    {
+        // backtrace() loads the unwinder the first time, which must not happen inside the handler
+        void *warmUp[1];
+        backtrace(warmUp, 1);
+
+        struct sigaction action = {};
+        action.sa_handler = onSampleSignal;
+        action.sa_flags = SA_RESTART; // Blocking calls the thread is stuck in carry on afterwards
+        sigemptyset(&action.sa_mask);
+        samplingReady = sigaction(sampleSignal, &action, nullptr) == 0;
+        watchedThread = pthread_self();
+    }
+
+    int sampleStack(void **frames, int capacity)
+    {
+        // A signal that never got handled (the thread is stuck in the kernel) is not sent again
+        if (!samplingReady || signalPending.load(std::memory_order_acquire))
+            return 0;
+
+        signalPending.store(true, std::memory_order_relaxed);
+        if (pthread_kill(watchedThread, sampleSignal) != 0)
+        {
+            signalPending.store(false, std::memory_order_relaxed);
+            return 0;
+        }
+
+        for (int waited = 0; signalPending.load(std::memory_order_acquire); ++waited)
+        {
+            if (waited == WATCHDOG_POLL_MS)
+                return 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // The handler's own frame and the signal trampoline come first
+        int depth = 0;
+        for (int i = 2; i < signalDepth && depth < capacity; ++i)
+            frames[depth++] = signalFrames[i];
+        return depth;
+    }
+
+    void describeFrame(std::ostream &out, void *address)
+    {
+        Dl_info info;
+        if (dladdr(address, &info) && info.dli_fname != nullptr)
+        {
+            out << std::filesystem::path(info.dli_fname).filename().string() << "+0x" << std::hex
+                << (static_cast<char *>(address) - static_cast<char *>(info.dli_fbase)) << std::dec;
+            if (info.dli_sname != nullptr)
+                out << " (" << info.dli_sname << ")";
+            return;
+        }
+        out << address;
+    }
+#else
+    void prepareSampling()
+    {
+    }
+
+    int sampleStack(void **, int)
+    {
+        return 0;
+    }
+
+    void describeFrame(std::ostream &out, void *address)
+    {
+        out << address;
+    }
+#endif
+}
+
+const char *watchPhaseName(WatchPhase phase)
+{
+    return phaseNames[static_cast<size_t>(phase)];
+}
+
+Watchdog::Watchdog(const std::string &filename)
+    : filename(filename), thread(&Watchdog::watchLoop, this)
+{
+}
+
+Watchdog::~Watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping.store(true, std::memory_order_release);
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void Watchdog::attach()
+{
+    prepareSampling();
+    onWatchedThread = true;
+    currentPhase.store(static_cast<std::uint8_t>(WatchPhase::Frame), std::memory_order_relaxed);
+    lastBeatUs.store(nowUs(), std::memory_order_relaxed);
+    armed.store(true, std::memory_order_release);
+}
+
+void Watchdog::detach()
+{
+    armed.store(false, std::memory_order_release);
+}
+
+void Watchdog::beat(GameState state, std::uint64_t frame, std::uint32_t length, int score)
+{
+    // Only this thread writes the heartbeat, so plain stores will do
+    const std::int64_t now = nowUs();
+    const std::int64_t frameUs = now - lastBeatUs.load(std::memory_order_relaxed);
+    if (frameUs >= WATCHDOG_DEADLINE_MS * 1000)
+    {
+        longFrameUs.store(frameUs, std::memory_order_relaxed);
+        longFrames.store(longFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    this->state.store(static_cast<std::uint8_t>(state), std::memory_order_relaxed);
+    this->frame.store(frame, std::memory_order_relaxed);
+    this->length.store(length, std::memory_order_relaxed);
+    this->score.store(score, std::memory_order_relaxed);
+    currentPhase.store(static_cast<std::uint8_t>(WatchPhase::Frame), std::memory_order_relaxed);
+    lastBeatUs.store(now, std::memory_order_relaxed);
+    beats.store(beats.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+WatchdogStats Watchdog::getStats() const
+{
+    WatchdogStats stats;
+    stats.hitches = hitches.load(std::memory_order_relaxed);
+    stats.worstMs = worstMs.load(std::memory_order_relaxed);
+    stats.lastPhase = static_cast<WatchPhase>(lastPhase.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void Watchdog::watchLoop()
+{
+    Hitch hitch;
+    bool stalled = false;
+    std::uint64_t seenLongFrames = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(WATCHDOG_POLL_MS));
+            if (stopping.load(std::memory_order_acquire))
+                return;
+        }
+
+        if (!armed.load(std::memory_order_acquire))
+        {
+            stalled = false;
+            seenLongFrames = longFrames.load(std::memory_order_relaxed);
+            continue;
+        }
+
+        const std::uint64_t beat = beats.load(std::memory_order_acquire);
+        const std::int64_t now = nowUs();
+
+        // The stalled frame finished, its length is known now
+        if (stalled && beat != hitch.beat)
+        {
+            stalled = false;
+            seenLongFrames = longFrames.load(std::memory_order_relaxed);
+            record(hitch, static_cast<std::uint32_t>(longFrameUs.load(std::memory_order_relaxed) / 1000));
+            continue;
+        }
+
+        if (!stalled)
+        {
+            hitch.state = static_cast<GameState>(state.load(std::memory_order_relaxed));
+            hitch.frame = frame.load(std::memory_order_relaxed);
+            hitch.length = length.load(std::memory_order_relaxed);
+            hitch.score = score.load(std::memory_order_relaxed);
+            hitch.sampleCount = 0;
+
+            // Over the deadline but done before a poll saw it, logged without a phase or stack
+            const std::uint64_t longs = longFrames.load(std::memory_order_relaxed);
+            if (longs != seenLongFrames)
+            {
+                seenLongFrames = longs;
+                hitch.phase = WatchPhase::Count;
+                record(hitch, static_cast<std::uint32_t>(longFrameUs.load(std::memory_order_relaxed) / 1000));
+            }
+
+            hitch.startUs = lastBeatUs.load(std::memory_order_relaxed);
+            if (now - hitch.startUs < WATCHDOG_DEADLINE_MS * 1000)
+                continue;
+
+            stalled = true;
+            hitch.beat = beat;
+            hitch.phase = static_cast<WatchPhase>(currentPhase.load(std::memory_order_relaxed));
+        }
+
+        // One sample per poll for as long as the frame is stuck, up to the limit
+        if (hitch.sampleCount < WATCHDOG_SAMPLES)
+        {
+            Sample &sample = hitch.samples[hitch.sampleCount++];
+            sample.atMs = static_cast<std::uint32_t>((now - hitch.startUs) / 1000);
+            sample.phase = static_cast<WatchPhase>(currentPhase.load(std::memory_order_relaxed));
+            sample.depth = sampleStack(sample.frames, WATCHDOG_STACK_DEPTH);
+        }
+    }
+}
+
+void Watchdog::record(const Hitch &hitch, std::uint32_t durationMs)
+{
+    hitches.fetch_add(1, std::memory_order_relaxed);
+    if (durationMs > worstMs.load(std::memory_order_relaxed))
+        worstMs.store(durationMs, std::memory_order_relaxed);
+    if (hitch.phase != WatchPhase::Count)
+        lastPhase.store(static_cast<std::uint8_t>(hitch.phase), std::memory_order_relaxed);
+
+    const char *phase = hitch.phase == WatchPhase::Count ? "an unsampled frame" : watchPhaseName(hitch.phase);
+    std::cerr << "Hitch of " << durationMs << " ms in " << phase << ", see " << filename << std::endl;
+
+    // Rolled over here rather than trimmed, the old file keeps the previous stretch whole
+    std::error_code error;
+    if (std::filesystem::file_size(filename, error) >= WATCHDOG_LOG_BYTES && !error)
+        std::filesystem::rename(filename, WATCHDOG_OLD_LOG_FILE, error);
+
+    std::ofstream file(filename, std::ios::app);
+    if (!file)
+        return;
+
+    char timestamp[32];
+    std::time_t wall = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", std::localtime(&wall));
+
+    file << timestamp << "  " << durationMs << " ms hitch in " << phase
+         << "  state " << stateNames[static_cast<size_t>(hitch.state)] << "  frame " << hitch.frame
+         << "  length " << hitch.length << "  score " << hitch.score << "\n";
+    for (int i = 0; i < hitch.sampleCount; ++i)
+    {
+        const Sample &sample = hitch.samples[i];
+        file << "  sample at " << sample.atMs << " ms in " << watchPhaseName(sample.phase);
+        if (sample.depth == 0)
+            file << ", no stack";
+        file << "\n";
+        for (int f = 0; f < sample.depth; ++f)
+        {
+            file << "    ";
+            describeFrame(file, sample.frames[f]);
+            file << "\n";
+        }
+    }
+}
+
+PhaseMarker::PhaseMarker(WatchPhase phase)
+    : previous(WatchPhase::Frame), watched(onWatchedThread)
+{
+    if (!watched)
+        return;
+
+    previous = static_cast<WatchPhase>(currentPhase.load(std::memory_order_relaxed));
+    currentPhase.store(static_cast<std::uint8_t>(phase), std::memory_order_relaxed);
+}
+
+PhaseMarker::~PhaseMarker()
+{
+    if (watched)
+        currentPhase.store(static_cast<std::uint8_t>(previous), std::memory_order_relaxed);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "types.hpp"
+
+#define WATCHDOG_LOG_FILE "hitches.log"
+#define WATCHDOG_OLD_LOG_FILE "hitches.old.log"
+#define WATCHDOG_LOG_BYTES (256 * 1024) // The log rolls over to the old file past this size
+#define WATCHDOG_DEADLINE_MS 100        // A frame taking longer than this is a hitch
+#define WATCHDOG_POLL_MS 20             // How often the watchdog looks at the heartbeat
+#define WATCHDOG_SAMPLES 8              // Stack samples kept per hitch, one per poll while it lasts
+#define WATCHDOG_STACK_DEPTH 32
+
+// What the main thread is in the middle of, set with PhaseMarker
+enum class WatchPhase
+{
+    Frame,
+    Transition,
+    Events,
+    Simulation,
+    FoodSpawn,
+    Autopilot,
+    Draw,
+    Present,
+    Music,
+    HighScore,
+    Snapshot,
+    Stats,
+    Count
+};
+
+const char *watchPhaseName(WatchPhase phase);
+
+struct WatchdogStats
+{
+    std::uint64_t hitches = 0;
+    std::uint32_t worstMs = 0;
+    WatchPhase lastPhase = WatchPhase::Frame; // Where the main thread was during the latest hitch
+};
+
+// Watches a once-per-frame heartbeat from another thread. While a frame is overdue it samples
+// the main thread's stack, and once the frame finishes it appends the phase, the game state and
+// the samples to a rolling log. The main thread only ever does a few relaxed stores.
+class Watchdog
+{
+public:
+    explicit Watchdog(const std::string &filename = WATCHDOG_LOG_FILE);
+    ~Watchdog();
+
+    Watchdog(const Watchdog &) = delete;
+    Watchdog &operator=(const Watchdog &) = delete;
+
+    // Called on the thread to watch, marks it for phase markers and stack samples
+    void attach();
+    // Stops watching, for when the loop ends or is about to block on purpose
+    void detach();
+
+    // Once per frame from the watched thread
+    void beat(GameState state, std::uint64_t frame, std::uint32_t length, int score);
+
+    WatchdogStats getStats() const;
+
+private:
+    struct Sample
+    {
+        std::uint32_t atMs; // Into the stall
+        WatchPhase phase;
+        int depth;
+        void *frames[WATCHDOG_STACK_DEPTH];
+    };
+
+    struct Hitch
+    {
+        std::uint64_t beat;
+        std::int64_t startUs;
+        GameState state;
+        std::uint64_t frame;
+        std::uint32_t length;
+        int score;
+        WatchPhase phase;
+        int sampleCount;
+        Sample samples[WATCHDOG_SAMPLES];
+    };
+
+    void watchLoop();
+    void record(const Hitch &hitch, std::uint32_t durationMs);
+
+    std::string filename;
+
+    // Heartbeat, written by the watched thread
+    std::atomic<bool> armed{false};
+    std::atomic<std::uint64_t> beats{0};
+    std::atomic<std::int64_t> lastBeatUs{0};
+    std::atomic<std::int64_t> longFrameUs{0}; // Length of the latest frame over the deadline
+    std::atomic<std::uint64_t> longFrames{0};
+    std::atomic<std::uint8_t> state{0};
+    std::atomic<std::uint64_t> frame{0};
+    std::atomic<std::uint32_t> length{0};
+    std::atomic<int> score{0};
+
+    std::atomic<std::uint64_t> hitches{0};
+    std::atomic<std::uint32_t> worstMs{0};
+    std::atomic<std::uint8_t> lastPhase{0};
+
+    std::atomic<bool> stopping{false};
+    std::mutex wakeMutex; // Only the watchdog ever sleeps on this
+    std::condition_variable wake;
+    std::thread thread;
+};
+
+// Tags what the watched thread is doing until it goes out of scope, free on other threads
+class PhaseMarker
+{
+public:
+    explicit PhaseMarker(WatchPhase phase);
+    ~PhaseMarker();
+
+    PhaseMarker(const PhaseMarker &) = delete;
+    PhaseMarker &operator=(const PhaseMarker &) = delete;
+
+private:
+    WatchPhase previous;
+    bool watched;
+};